@@ -2,7 +2,7 @@ from __future__ import division, print_function, absolute_import
 import numpy as np
 from numba import jit
 from sweetsourcod.lempel_ziv import lempel_ziv_complexity
-from sweetsourcod.hilbert import get_hilbert_mask
+from sweetsourcod.hilbert import get_hilbert_mask, get_pseudo_hilbert_mask
 from sweetsourcod.zipper_compress import get_comp_size_bytes
 from sweetsourcod.block_entropy import block_entropy
 from PIL import Image
@@ -101,7 +101,7 @@ if __name__ == "__main__":
     lattice_boxv = np.asarray(image.shape[::-1])
     n = np.prod(lattice_boxv)
 
-    # we need to flatten the image, choose between raster and hilbert
+    # we need to flatten the image, choose between raster, hilbert and pseudo-hilbert
     scan = 'hilbert'
 
     if scan == 'raster':
@@ -115,6 +115,10 @@ if __name__ == "__main__":
         n = np.prod(lattice_boxv)
         hilbert_mask = get_hilbert_mask(lattice_boxv)
         image_flat = mask_array(image.ravel(), hilbert_mask).astype('uint8')
+    elif scan == 'pseudo-hilbert':
+        # the generalized hilbert curve scans the whole image whatever its side lengths
+        pseudo_hilbert_mask = get_pseudo_hilbert_mask(lattice_boxv)
+        image_flat = mask_array(image.ravel(), pseudo_hilbert_mask).astype('uint8')
     else:
         raise NotImplementedError
 
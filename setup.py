@@ -128,14 +128,41 @@ elif jargs.compiler in ("intel", "icc", "icpc"):
 
 extra_compile_args = ["-std=c++11", "-Wall", "-Wextra", "-pedantic", "-O3", "-fPIC"]
 if idcompiler.lower() == 'unix':
-    extra_compile_args += ['-march=native', '-flto']  # , '-fopenmp'
-    #extra_compile_args += ['-flto']  # , '-fopenmp'
+    extra_compile_args += ['-march=native', '-flto', '-fopenmp']
+    #extra_compile_args += ['-flto', '-fopenmp']
+    extra_link_args = ["-std=c++11", "-fopenmp"]
 else:
     extra_compile_args += ['-axCORE-AVX2', '-ipo', '-ip', '-unroll',
-                           '-qopt-report-stdout', '-qopt-report-phase=openmp'] # '-qopenmp',
+                           '-qopt-report-stdout', '-qopt-report-phase=openmp', '-qopenmp']
+    extra_link_args = ["-std=c++11", "-qopenmp"]
 
 include_sources_all = include_sources_sweetsourcod
 
+
+def find_codecs():
+    """
+    macros and libraries of the compression codecs whose headers are found, for the native
+    compressed-size module (source/sweetsourcod/compress_size.hpp)
+    """
+    codecs = [('SSC_HAVE_ZLIB', 'zlib.h', ['z']),
+              ('SSC_HAVE_BZIP2', 'bzlib.h', ['bz2']),
+              ('SSC_HAVE_LZMA', 'lzma.h', ['lzma']),
+              ('SSC_HAVE_ZSTD', 'zstd.h', ['zstd']),
+              ('SSC_HAVE_BROTLI', 'brotli/encode.h', ['brotlienc'])]
+    search_dirs = [os.path.join(sys.prefix, 'include'), '/usr/local/include', '/usr/include']
+    search_dirs = os.environ.get('CPATH', '').split(os.pathsep) + search_dirs
+    macros, libraries = [], []
+    for macro, header, libs in codecs:
+        if any(d and os.path.exists(os.path.join(d, header)) for d in search_dirs):
+            macros.append((macro, None))
+            libraries += libs
+    return macros, libraries
+
+
+codec_macros, codec_libraries = find_codecs()
+print("compression codecs:", [m for m, _ in codec_macros])
+
+
 depends_all = depends_sweetsourcod
 
 print(depends_all)
@@ -146,7 +173,7 @@ cxx_modules = [
                   include_dirs=include_dirs,
                   extra_compile_args=extra_compile_args,
                   libraries=['m'],
-                  extra_link_args=["-std=c++11"],
+                  extra_link_args=extra_link_args,
                   language="c++", depends=depends_all,
                   ),
     Extension("sweetsourcod.block_entropy",
@@ -154,7 +181,7 @@ cxx_modules = [
                   include_dirs=include_dirs,
                   extra_compile_args=extra_compile_args,
                   libraries=['m'],
-                  extra_link_args=["-std=c++11"],
+                  extra_link_args=extra_link_args,
                   language="c++", depends=depends_all,
                   ),
     Extension("sweetsourcod.block_sorting",
@@ -162,7 +189,7 @@ cxx_modules = [
                   include_dirs=include_dirs,
                   extra_compile_args=extra_compile_args,
                   libraries=['m'],
-                  extra_link_args=["-std=c++11"],
+                  extra_link_args=extra_link_args,
                   language="c++", depends=depends_all,
                   ),
     Extension("sweetsourcod.hilbert",
@@ -170,7 +197,7 @@ cxx_modules = [
                   include_dirs=include_dirs,
                   extra_compile_args=extra_compile_args,
                   libraries=['m'],
-                  extra_link_args=["-std=c++11"],
+                  extra_link_args=extra_link_args,
                   language="c++", depends=depends_all,
                   ),
     Extension("sweetsourcod.gosper",
@@ -178,7 +205,40 @@ cxx_modules = [
                   include_dirs=include_dirs,
                   extra_compile_args=extra_compile_args,
                   libraries=['m'],
-                  extra_link_args=["-std=c++11"],
+                  extra_link_args=extra_link_args,
+                  language="c++", depends=depends_all,
+                  ),
+    Extension("sweetsourcod.sequence_index",
+                  ["sweetsourcod/sequence_index.cxx"] + include_sources_all,
+                  include_dirs=include_dirs,
+                  extra_compile_args=extra_compile_args,
+                  libraries=['m'],
+                  extra_link_args=extra_link_args,
+                  language="c++", depends=depends_all,
+                  ),
+    Extension("sweetsourcod.bit_packing",
+                  ["sweetsourcod/bit_packing.cxx"],
+                  include_dirs=include_dirs,
+                  extra_compile_args=extra_compile_args,
+                  libraries=['m'],
+                  extra_link_args=extra_link_args,
+                  language="c++", depends=depends_all,
+                  ),
+    Extension("sweetsourcod.run_length",
+                  ["sweetsourcod/run_length.cxx"],
+                  include_dirs=include_dirs,
+                  extra_compile_args=extra_compile_args,
+                  libraries=['m'],
+                  extra_link_args=extra_link_args,
+                  language="c++", depends=depends_all,
+                  ),
+    Extension("sweetsourcod.compress_size",
+                  ["sweetsourcod/compress_size.cxx"],
+                  include_dirs=include_dirs,
+                  define_macros=codec_macros,
+                  extra_compile_args=extra_compile_args,
+                  libraries=['m'] + codec_libraries,
+                  extra_link_args=extra_link_args,
                   language="c++", depends=depends_all,
                   )
 
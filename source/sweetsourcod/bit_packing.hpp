@@ -0,0 +1,181 @@
+#ifndef SSC_BIT_PACKING_H
+#define SSC_BIT_PACKING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ssc
+{
+
+// Minimal binary representation: each symbol written with nbits bits, most significant bit
+// first, symbols concatenated and the last byte padded with zero bits, i.e. the bytes of
+// bitarray(''.join(format(x, '0{nbits}b') for x in seq)) in utils.get_bytes.
+// Any nbits in [1, 32] is supported; nbits = 1, 2, 4 (uint8 input) have SIMD fast paths and
+// nbits = 8, 16 are copied byte-wise.
+
+inline size_t packed_size(const size_t n, const int nbits) {
+	return (n * static_cast<size_t>(nbits) + 7) / 8;
+}
+
+inline void check_nbits(const int nbits) {
+	if (nbits < 1 || nbits > 32) { throw std::runtime_error("nbits must be in [1, 32]"); }
+}
+
+// scalar packing of seq[begin..n-1] into out, begin * nbits being a multiple of 8
+template<class T>
+void pack_bits_scalar(const T* seq, const size_t begin, const size_t n, const int nbits, uint8_t* out) {
+	uint64_t acc = 0;
+	int bits = 0;
+	size_t k = begin * static_cast<size_t>(nbits) / 8;
+	for (size_t i = begin; i < n; ++i) {
+		acc = (acc << nbits) | static_cast<uint64_t>(seq[i]);
+		bits += nbits;
+		while (bits >= 8) {
+			bits -= 8;
+			out[k++] = static_cast<uint8_t>(acc >> bits);
+		}
+	}
+	if (bits > 0) {
+		out[k] = static_cast<uint8_t>(acc << (8 - bits));
+	}
+}
+
+// SIMD packing of a prefix of seq, return the number of symbols packed
+inline size_t pack_bits_simd(const unsigned char* seq, const size_t n, const int nbits, uint8_t* out) {
+	size_t i = 0;
+#if defined(__AVX2__)
+	if (nbits == 1) {
+		// reverse the bytes of each group of 8 so that the first symbol lands on the highest
+		// bit of its output byte, then move the lowest bit of every byte into a 32 bit mask
+		const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+												 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for (; i + 32 <= n; i += 32) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seq + i));
+			v = _mm256_slli_epi16(_mm256_shuffle_epi8(v, reverse), 7);
+			const uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+			std::memcpy(out + i / 8, &bits, 4);
+		}
+		return i;
+	}
+#endif
+#if defined(__SSSE3__)
+	if (nbits == 1) {
+		const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for (; i + 16 <= n; i += 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + i));
+			v = _mm_slli_epi16(_mm_shuffle_epi8(v, reverse), 7);
+			const uint16_t bits = static_cast<uint16_t>(_mm_movemask_epi8(v));
+			std::memcpy(out + i / 8, &bits, 2);
+		}
+	}
+	else if (nbits == 4) {
+		// (a, b) -> 16 a + b in 16 bit lanes, narrowed to bytes
+		const __m128i weights = _mm_set1_epi16(0x0110);
+		for (; i + 32 <= n; i += 32) {
+			const __m128i lo = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + i)), weights);
+			const __m128i hi = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + i + 16)), weights);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), _mm_packus_epi16(lo, hi));
+		}
+	}
+	else if (nbits == 2) {
+		// (a, b) -> 4 a + b, then (c, d) -> 16 c + d in 32 bit lanes, narrowed to bytes
+		const __m128i weights8 = _mm_set1_epi16(0x0104);
+		const __m128i weights16 = _mm_set1_epi32(0x00010010);
+		for (; i + 64 <= n; i += 64) {
+			__m128i v[4];
+			for (int b = 0; b < 4; ++b) {
+				const __m128i pairs = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + i + 16 * b)), weights8);
+				v[b] = _mm_madd_epi16(pairs, weights16);
+			}
+			const __m128i lo = _mm_packs_epi32(v[0], v[1]);
+			const __m128i hi = _mm_packs_epi32(v[2], v[3]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 4), _mm_packus_epi16(lo, hi));
+		}
+	}
+#else
+	(void) seq;
+	(void) n;
+	(void) nbits;
+	(void) out;
+#endif
+	return i;
+}
+
+// pack the n symbols of seq, each < 2^nbits, into out[0..packed_size(n, nbits)-1]
+template<class T>
+void pack_bits(const T* seq, const size_t n, const int nbits, uint8_t* out) {
+	check_nbits(nbits);
+	const uint64_t limit = uint64_t(1) << nbits;
+	bool fits = true;
+	for (size_t i = 0; i < n; ++i) {
+		fits &= static_cast<uint64_t>(seq[i]) < limit;
+	}
+	if (!fits) { throw std::runtime_error("pack_bits: nbits not sufficient to represent the sequence"); }
+	if (nbits == 8) {
+		for (size_t i = 0; i < n; ++i) out[i] = static_cast<uint8_t>(seq[i]);
+		return;
+	}
+	if (nbits == 16) {
+		for (size_t i = 0; i < n; ++i) {
+			out[2 * i] = static_cast<uint8_t>(seq[i] >> 8);
+			out[2 * i + 1] = static_cast<uint8_t>(seq[i]);
+		}
+		return;
+	}
+	size_t begin = 0;
+	if (std::is_same<T, unsigned char>::value) {
+		begin = pack_bits_simd(reinterpret_cast<const unsigned char*>(seq), n, nbits, out);
+	}
+	pack_bits_scalar(seq, begin, n, nbits, out);
+}
+
+// unpack n symbols of nbits bits from packed into out
+template<class T>
+void unpack_bits(const uint8_t* packed, const size_t n, const int nbits, T* out) {
+	check_nbits(nbits);
+	if (nbits == 8) {
+		for (size_t i = 0; i < n; ++i) out[i] = static_cast<T>(packed[i]);
+		return;
+	}
+	if (nbits == 16) {
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = static_cast<T>((packed[2 * i] << 8) | packed[2 * i + 1]);
+		}
+		return;
+	}
+	if (nbits == 1) {
+		const size_t whole = n / 8;
+		for (size_t k = 0; k < whole; ++k) {
+			const uint8_t byte = packed[k];
+			for (int j = 0; j < 8; ++j) {
+				out[8 * k + j] = static_cast<T>((byte >> (7 - j)) & 1);
+			}
+		}
+		for (size_t i = 8 * whole; i < n; ++i) {
+			out[i] = static_cast<T>((packed[i / 8] >> (7 - i % 8)) & 1);
+		}
+		return;
+	}
+	const uint64_t symbol_mask = (uint64_t(1) << nbits) - 1;
+	uint64_t acc = 0;
+	int bits = 0;
+	size_t k = 0;
+	for (size_t i = 0; i < n; ++i) {
+		while (bits < nbits) {
+			acc = (acc << 8) | packed[k++];
+			bits += 8;
+		}
+		bits -= nbits;
+		out[i] = static_cast<T>((acc >> bits) & symbol_mask);
+	}
+}
+
+}
+#endif // #ifndef
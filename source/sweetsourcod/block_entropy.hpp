@@ -2,6 +2,7 @@
 #define SSC_BLOCK_ENTROPY_H
 
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
@@ -44,5 +45,147 @@ double block_entropy_cpp(const std::vector<T> lattice, const size_t blocksize=6)
     return block_entropy_cpp(sequence, blocksize);
 }
 
+// stateful block entropy for sequences that change one site at a time (e.g. Metropolis
+// Monte Carlo). Keeps the block histogram and the running sum_b c_b log2 c_b so that
+// the entropy log2(N) - sum/N is available in O(1) and a site update costs O(blocksize).
+// Blocks are keyed by an integer code updated one digit at a time: the block itself in base
+// 256 for blocksize <= 8, a polynomial hash modulo 2^61 - 1 for longer blocks (two distinct
+// blocks collide with probability about blocksize / 2^61)
+class BlockEntropyTracker{
+    static const uint64_t hash_modulus = (uint64_t(1) << 61) - 1;
+    static const uint64_t hash_base = 0x1d8e4e27c47d124fULL;
+
+    std::string m_sequence;
+    size_t m_blocksize;
+    size_t m_nblocks;
+    bool m_exact; // codes are the blocks in base 256
+    std::vector<uint64_t> m_weights; // weight of digit t of a block, t in [0, blocksize)
+    std::vector<uint64_t> m_codes; // code of the block starting at each site
+    std::unordered_map<uint64_t, size_t> m_counts;
+    std::vector<double> m_clogc; // c*log2(c) for c in [0, nblocks]
+    double m_sumclogc;
+
+    static uint64_t reduce(const uint64_t x){
+        const uint64_t r = (x & hash_modulus) + (x >> 61);
+        return (r >= hash_modulus) ? r - hash_modulus : r;
+    }
+
+    // a * b mod 2^61 - 1 for a, b < 2^61, from 31 and 30 bit halves
+    static uint64_t mul_mod(const uint64_t a, const uint64_t b){
+        const uint64_t mask31 = (uint64_t(1) << 31) - 1, mask30 = (uint64_t(1) << 30) - 1;
+        const uint64_t ah = a >> 31, al = a & mask31, bh = b >> 31, bl = b & mask31;
+        const uint64_t mid = al * bh + ah * bl;
+        return reduce(2 * ah * bh + (mid >> 30) + ((mid & mask30) << 31) + al * bl);
+    }
+
+    // code of symbol x as digit t of a block
+    uint64_t digit(const unsigned char x, const size_t t) const{
+        return m_exact ? m_weights[t] * x : mul_mod(m_weights[t], x);
+    }
+
+    uint64_t add_code(const uint64_t a, const uint64_t b) const{
+        return m_exact ? a + b : reduce(a + b);
+    }
+
+    uint64_t sub_code(const uint64_t a, const uint64_t b) const{
+        return m_exact ? a - b : reduce(a + hash_modulus - b);
+    }
+
+    void remove_block(const size_t i){
+        auto it = m_counts.find(m_codes[i]);
+        m_sumclogc -= m_clogc[it->second] - m_clogc[it->second - 1];
+        if (--(it->second) == 0){
+            m_counts.erase(it);
+        }
+    }
+
+    void add_block(const size_t i){
+        size_t& c = m_counts[m_codes[i]];
+        ++c;
+        m_sumclogc += m_clogc[c] - m_clogc[c - 1];
+    }
+
+public:
+    BlockEntropyTracker(const std::string& sequence, const size_t blocksize=6)
+        : m_sequence(sequence),
+          m_blocksize(blocksize),
+          m_nblocks(0),
+          m_exact(blocksize <= 8),
+          m_sumclogc(0)
+    {
+        if (blocksize == 0){throw std::runtime_error("BlockEntropyTracker: blocksize must be positive");}
+        if (sequence.size() < blocksize){throw std::runtime_error("BlockEntropyTracker: sequence shorter than blocksize");}
+        m_nblocks = sequence.size() - blocksize + 1;
+        m_clogc.resize(m_nblocks + 1);
+        m_clogc[0] = 0;
+        for (size_t c=1; c<=m_nblocks; ++c){
+            m_clogc[c] = (double) c * std::log2((double) c);
+        }
+        m_weights.resize(blocksize);
+        m_weights[blocksize - 1] = 1;
+        for (size_t t=blocksize - 1; t>0; --t){
+            m_weights[t - 1] = m_exact ? m_weights[t] << 8 : mul_mod(m_weights[t], hash_base);
+        }
+        // rolling codes: drop the leading digit, shift, append the next symbol
+        m_codes.resize(m_nblocks);
+        uint64_t code = 0;
+        for (size_t t=0; t<blocksize; ++t){
+            code = add_code(code, digit(static_cast<unsigned char>(sequence[t]), t));
+        }
+        m_codes[0] = code;
+        for (size_t i=1; i<m_nblocks; ++i){
+            code = sub_code(code, digit(static_cast<unsigned char>(sequence[i - 1]), 0));
+            code = m_exact ? code << 8 : mul_mod(code, hash_base);
+            code = add_code(code, static_cast<unsigned char>(sequence[i + blocksize - 1]));
+            m_codes[i] = code;
+        }
+        for (size_t i=0; i<m_nblocks; ++i){
+            add_block(i);
+        }
+    }
+
+    template<class T=long long>
+    BlockEntropyTracker(const std::vector<T> lattice, const size_t blocksize=6)
+        : BlockEntropyTracker(int_vector_to_string<T>(lattice), blocksize)
+    {}
+
+    // set site i to symbol x, replacing one digit of the codes of the (at most blocksize)
+    // blocks covering i
+    void update(const size_t i, const long long x){
+        if (i >= m_sequence.size()){throw std::runtime_error("BlockEntropyTracker: site index out of range");}
+        if (x < 0 || x > 255){throw std::runtime_error("BlockEntropyTracker: symbol must be in [0, 255]");}
+        const char symbol = static_cast<char>(x);
+        if (m_sequence[i] == symbol){
+            return;
+        }
+        const size_t first = (i + 1 > m_blocksize) ? i + 1 - m_blocksize : 0;
+        const size_t last = std::min(i, m_nblocks - 1);
+        const unsigned char previous = static_cast<unsigned char>(m_sequence[i]);
+        for (size_t j=first; j<=last; ++j){
+            remove_block(j);
+            m_codes[j] = add_code(sub_code(m_codes[j], digit(previous, i - j)), digit(static_cast<unsigned char>(x), i - j));
+            add_block(j);
+        }
+        m_sequence[i] = symbol;
+    }
+
+    template<class T=long long>
+    void apply_updates(const std::vector<size_t>& sites, const std::vector<T>& symbols){
+        if (sites.size() != symbols.size()){throw std::runtime_error("BlockEntropyTracker: sites and symbols sizes do not match");}
+        for (size_t k=0; k<sites.size(); ++k){
+            update(sites[k], static_cast<long long>(symbols[k]));
+        }
+    }
+
+    double entropy() const{
+        return std::log2((double) m_nblocks) - m_sumclogc / (double) m_nblocks;
+    }
+
+    size_t blocksize() const{ return m_blocksize; }
+    size_t size() const{ return m_sequence.size(); }
+    size_t nblocks() const{ return m_nblocks; }
+    size_t nunique() const{ return m_counts.size(); }
+};
+
 }
 #endif // #ifndef
\ No newline at end of file
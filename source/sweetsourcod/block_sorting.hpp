@@ -11,25 +11,72 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
-#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include <utility>
 
 #include "kkp/divsufsort.h"
 #include "sweetsourcod/lempel_ziv.hpp"
+#include "sweetsourcod/parallel.hpp"
+#include "sweetsourcod/suffix_sort.hpp"
 
 namespace ssc 
 {
 
-inline std::string burrows_wheeler_transform(std::string& sequence) {
-	size_t length = sequence.size();
-	std::shared_ptr<unsigned char> text(new unsigned char[length], std::default_delete<unsigned char[]>());
-	std::shared_ptr<unsigned char>    u(new unsigned char[length], std::default_delete<unsigned char[]>());
-
-	std::reverse(sequence.begin(), sequence.end());
-	memcpy(text.get(), sequence.c_str(), length);
-	divbwt(text.get(), u.get(), NULL, length);
+// the same output as burrows_wheeler_transform_into, from the suffix array sa of the
+// already reversed text rtext: the last symbol first, then the symbols preceding each
+// suffix in lexicographic order, skipping the suffix starting at 0. returns the primary index
+inline int bwt_from_suffix_array(const unsigned char* rtext, const int* sa, const int length, unsigned char* out) {
+	if (length == 0) { return 0; }
+	int pidx = 0;
+	out[0] = rtext[length - 1];
+	for (int i = 0, j = 1; i < length; ++i) {
+		if (sa[i] == 0) {
+			pidx = i + 1;
+		} else {
+			out[j++] = rtext[sa[i] - 1];
+		}
+	}
+	return pidx;
+}
 
-	std::string str_bwt(reinterpret_cast<char const*>(u.get()), length);
+// write the Burrows-Wheeler transform of the reversed text[0..length-1] into out[0..length-1]
+// without modifying text. The reversal is written straight into out and divbwt then runs in
+// place, so no intermediate buffers are allocated. workspace, if not NULL, must hold at
+// least length + 1 ints and can be reused across calls to avoid divbwt's own allocation.
+// nthreads sets the number of threads of the suffix sorting (0 for the OpenMP default); from
+// parallel_suffix_sort_min_threads the transform is read off the parallel DC3 suffix array,
+// with workspace holding it. returns the primary index
+inline int burrows_wheeler_transform_into(const unsigned char* text, const size_t length, unsigned char* out, int* workspace=NULL,
+										  const int nthreads=1) {
+	if (length > static_cast<size_t>(std::numeric_limits<int>::max())) {
+		throw std::runtime_error("burrows_wheeler_transform: sequence too long for divbwt");
+	}
+	const int n = static_cast<int>(length);
+	const int nt = parallel_suffix_sort_threads(n, nthreads);
+	if (nt > 0) {
+		std::vector<unsigned char> rtext(text, text + length);
+		std::reverse(rtext.begin(), rtext.end());
+		std::vector<int> sa_buffer;
+		int* sa = workspace;
+		if (sa == NULL) {
+			sa_buffer.resize(length);
+			sa = sa_buffer.data();
+		}
+		parallel_suffix_sort(rtext.data(), sa, n, nt);
+		return bwt_from_suffix_array(rtext.data(), sa, n, out);
+	}
+	std::reverse_copy(text, text + length, out);
+	ScopedNumThreads threads(nthreads);
+	int pidx = divbwt(out, out, workspace, static_cast<int>(length));
+	if (pidx < 0) { throw std::runtime_error("burrows_wheeler_transform: divbwt failed"); }
+	return pidx;
+}
 
+inline std::string burrows_wheeler_transform(const std::string& sequence) {
+	std::string str_bwt(sequence.size(), '\0');
+	burrows_wheeler_transform_into(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size(),
+		reinterpret_cast<unsigned char*>(&str_bwt[0]));
 	return str_bwt;
 }
 	
@@ -37,52 +84,82 @@ inline std::string burrows_wheeler_transform(std::string& sequence) {
 template<class T = long long>
 std::vector<unsigned char> burrows_wheeler_transform(const std::vector<T> lattice) {
 	std::string sequence = int_vector_to_string<T>(lattice);
-	std::string str_bwt = burrows_wheeler_transform(sequence);
-	std::vector<unsigned char> vec_bwt(str_bwt.begin(), str_bwt.end());
+	std::vector<unsigned char> vec_bwt(sequence.size());
+	burrows_wheeler_transform_into(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size(), vec_bwt.data());
 
 	return vec_bwt;
 }
 
-inline double sumlogp_segment(const std::string& sequence) {
-	std::unordered_map<char, std::shared_ptr<size_t>> umap;
-	size_t length = sequence.size();
-
-	for (size_t i = 0; i < length; ++i) {
-		const char symbol = sequence[i];
-		auto it = umap.find(symbol);
-		if (it != umap.end()) {
-			*(it -> second) += 1;
-		} else {
-			umap.insert({ symbol, std::make_shared<size_t>(1) });
+// sum_c n_c log2(n_c / length) over the symbol counts n_c of segment[0..length-1].
+// Binary segments are counted with a plain (vectorisable) sum; otherwise four interleaved
+// 256-entry histograms avoid the store-to-load dependency on runs of equal symbols
+inline double sumlogp_segment(const unsigned char* segment, const size_t length, const bool binary=false) {
+	if (length == 0) { return 0; }
+	double sumlogp = 0;
+
+	if (binary) {
+		size_t ones = 0;
+		for (size_t i = 0; i < length; ++i) {
+			ones += segment[i];
+		}
+		const size_t counts[2] = { length - ones, ones };
+		for (const auto& c : counts) {
+			if (c > 0) sumlogp += (double)c * std::log2((double)c / (double)length);
 		}
+		return sumlogp;
 	}
 
-	double sumlogp = 0;
-	for (const auto& symbol : umap) {
-		double p = (double)*symbol.second / (double)length;
-		sumlogp += (double)*symbol.second * std::log2(p);
+	uint32_t counts[4][256] = {};
+	size_t i = 0;
+	for (; i + 4 <= length; i += 4) {
+		++counts[0][segment[i]];
+		++counts[1][segment[i + 1]];
+		++counts[2][segment[i + 2]];
+		++counts[3][segment[i + 3]];
+	}
+	for (; i < length; ++i) {
+		++counts[0][segment[i]];
+	}
+	for (size_t symbol = 0; symbol < 256; ++symbol) {
+		const size_t c = (size_t)counts[0][symbol] + counts[1][symbol] + counts[2][symbol] + counts[3][symbol];
+		if (c > 0) sumlogp += (double)c * std::log2((double)c / (double)length);
 	}
 	
 	return sumlogp;
 }
 
-inline double block_sorting_estimator_uniform(std::string& sequence) {
-	size_t length = sequence.size();
+inline double sumlogp_segment(const std::string& sequence) {
+	return sumlogp_segment(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size());
+}
+
+// single streaming pass over the BWT, one histogram per segment of seg_len symbols
+inline double block_sorting_uniform_from_bwt(const unsigned char* bwt, const size_t length) {
+	if (length == 0) { return 0; }
 	size_t seg_len = std::ceil(std::sqrt(length));
-	std::string str_seg;
-	std::string str_bwt = burrows_wheeler_transform(sequence);
+	const bool binary = *std::max_element(bwt, bwt + length) <= 1;
 
 	double entropy = 0;
 	
 	for (size_t i = 0; i < length; i += seg_len) {
-		str_seg.assign(str_bwt, i, seg_len);
-		entropy -= sumlogp_segment(str_seg);
+		entropy -= sumlogp_segment(bwt + i, std::min(seg_len, length - i), binary);
 	}
 	entropy /= length;
 
 	return entropy;
 }
 
+inline double block_sorting_estimator_uniform(const unsigned char* text, const size_t length, int* workspace=NULL,
+											  const int nthreads=1) {
+	if (length == 0) { return 0; }
+	std::vector<unsigned char> bwt(length);
+	burrows_wheeler_transform_into(text, length, bwt.data(), workspace, nthreads);
+	return block_sorting_uniform_from_bwt(bwt.data(), length);
+}
+
+inline double block_sorting_estimator_uniform(const std::string& sequence) {
+	return block_sorting_estimator_uniform(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size());
+}
+
 //reverse sequence -> BWT -> uniform segmentation -> estimate entropy
 template<class T = long long>
 double block_sorting_estimator_uniform(const std::vector<T> lattice) {
@@ -90,5 +167,176 @@ double block_sorting_estimator_uniform(const std::vector<T> lattice) {
 	return block_sorting_estimator_uniform(sequence);
 }
 
+// Kasai et al. LCP array: lcp[i] is the length of the longest common prefix of the
+// suffixes sa[i-1] and sa[i] (lcp[0] = 0). isa is used as scratch and must hold length ints
+inline void lcp_array_kasai(const unsigned char* text, const int* sa, int* isa, int* lcp, const int length) {
+	for (int i = 0; i < length; ++i) {
+		isa[sa[i]] = i;
+	}
+	int h = 0;
+	for (int i = 0; i < length; ++i) {
+		if (isa[i] > 0) {
+			const int j = sa[isa[i] - 1];
+			while (i + h < length && j + h < length && text[i + h] == text[j + h]) ++h;
+			lcp[isa[i]] = h;
+			if (h > 0) --h;
+		} else {
+			lcp[0] = 0;
+			h = 0;
+		}
+	}
+}
+
+// symbol counts of a segment: (symbol, count) pairs sorted by symbol, nonzero counts only
+typedef std::vector<std::pair<unsigned char, size_t>> SymbolCounts;
+
+// adds the counts of from to into and clears from; the smaller set is merged into the larger
+inline void merge_symbol_counts(SymbolCounts& into, SymbolCounts& from) {
+	if (into.size() < from.size()) { std::swap(into, from); }
+	for (const auto& entry : from) {
+		auto it = std::lower_bound(into.begin(), into.end(), entry,
+								   [](const std::pair<unsigned char, size_t>& a, const std::pair<unsigned char, size_t>& b) {
+									   return a.first < b.first;
+								   });
+		if (it != into.end() && it->first == entry.first) {
+			it->second += entry.second;
+		} else {
+			into.insert(it, entry);
+		}
+	}
+	from.clear();
+}
+
+// Krichevsky-Trofimov code length in bits of a segment with the given symbol counts,
+// using tables lg_half[c] = lgamma(c + 1/2) and lg_total[m] = lgamma(m + sigma/2).
+// Absent symbols contribute nothing, so only the nonzero counts are visited
+inline double kt_code_length(const SymbolCounts& counts, const size_t total,
+							 const std::vector<double>& lg_half, const std::vector<double>& lg_total) {
+	double cost = lg_total[total] - lg_total[0];
+	for (const auto& entry : counts) {
+		cost -= lg_half[entry.second] - lg_half[0];
+	}
+	return cost / std::log(2.0);
+}
+
+// Adaptive segmentation of the BWT of the reversed sequence. Every node of the suffix tree
+// (an LCP interval of the suffix array) is a candidate segment sharing one context; the optimal
+// partition, as in compression boosting (Ferragina et al. 2005), is found bottom-up by keeping for
+// each node the cheaper of coding it as one KT segment or coding its children separately,
+// plus one bit per visited node to describe the partition itself.
+// Runs with a single stack traversal of the LCP array; every open interval keeps only the symbols
+// it contains, merged smaller into larger when a node is closed, so memory is O(n + sigma)
+// whatever the depth of the stack (e.g. long runs of one symbol).
+// rtext is the reversed sequence, sa and lcp its suffix and LCP arrays.
+// Returns the code length per symbol of the optimal partition; nsegments, if not NULL, receives its size.
+inline double block_sorting_adaptive_from_lcp(const unsigned char* rtext, const int* sa, const int* lcp, const int n,
+											  size_t* nsegments=NULL) {
+	if (n == 0) { return 0; }
+	const size_t length = n;
+	const size_t sigma = std::max<size_t>(2, 1 + *std::max_element(rtext, rtext + length));
+
+	std::vector<double> lg_half(length + 1), lg_total(length + 1);
+	for (size_t c = 0; c <= length; ++c) {
+		lg_half[c]  = std::lgamma(c + 0.5);
+		lg_total[c] = std::lgamma(c + 0.5 * sigma);
+	}
+
+	struct Interval {
+		int lcp;
+		double cost;      // sum of the optimal costs of the children
+		size_t total;
+		size_t nsegments; // segments in the optimal partition of the children
+		SymbolCounts counts;
+	};
+	std::vector<Interval> stack;
+	SymbolCounts carry_counts;
+	double carry_cost;
+	size_t carry_total, carry_nsegments;
+	// emptied small count buffers, reused by the next intervals to save one allocation per node
+	std::vector<SymbolCounts> spare_counts;
+
+	auto push = [&](const int h) {
+		stack.push_back({ h, 0., 0, 0, SymbolCounts() });
+		if (!spare_counts.empty()) {
+			stack.back().counts.swap(spare_counts.back());
+			spare_counts.pop_back();
+		}
+	};
+	auto add_carry_to_top = [&]() {
+		Interval& top = stack.back();
+		merge_symbol_counts(top.counts, carry_counts);
+		top.cost += carry_cost;
+		top.total += carry_total;
+		top.nsegments += carry_nsegments;
+	};
+
+	push(0);
+	for (int i = 1; i <= n; ++i) {
+		// the leaf i-1 holds the BWT symbol preceding suffix sa[i-1]
+		carry_counts.assign(1, std::make_pair(rtext[(sa[i - 1] + n - 1) % n], size_t(1)));
+		carry_cost = std::log2(static_cast<double>(sigma));
+		carry_total = 1;
+		carry_nsegments = 1;
+
+		const int lcp_i = (i < n) ? lcp[i] : -1;
+		while (!stack.empty() && lcp_i < stack.back().lcp) {
+			add_carry_to_top();
+			Interval node = std::move(stack.back());
+			stack.pop_back();
+			carry_counts.swap(node.counts);
+			if (node.counts.capacity() <= 16) {
+				node.counts.clear();
+				spare_counts.push_back(std::move(node.counts));
+			}
+
+			// one extra bit flags whether the node is kept whole or split
+			const double single_cost = kt_code_length(carry_counts, node.total, lg_half, lg_total);
+			if (single_cost <= node.cost) {
+				carry_cost = 1. + single_cost;
+				carry_nsegments = 1;
+			} else {
+				carry_cost = 1. + node.cost;
+				carry_nsegments = node.nsegments;
+			}
+			carry_total = node.total;
+		}
+		if (stack.empty()) { break; }
+		if (lcp_i > stack.back().lcp) {
+			push(lcp_i);
+		}
+		add_carry_to_top();
+	}
+
+	if (nsegments != NULL) { *nsegments = carry_nsegments; }
+	return carry_cost / n;
+}
+
+
+inline double block_sorting_estimator_adaptive(const unsigned char* text, const size_t length, size_t* nsegments=NULL,
+											   const int nthreads=1) {
+	if (length == 0) { return 0; }
+	if (length > static_cast<size_t>(std::numeric_limits<int>::max())) {
+		throw std::runtime_error("block_sorting_estimator_adaptive: sequence too long for divsufsort");
+	}
+	const int n = static_cast<int>(length);
+	std::vector<unsigned char> rtext(text, text + length);
+	std::reverse(rtext.begin(), rtext.end());
+
+	std::vector<int> sa(length), lcp(length);
+	{
+		std::vector<int> isa(length);
+		suffix_sort(rtext.data(), sa.data(), n, nthreads);
+		lcp_array_kasai(rtext.data(), sa.data(), isa.data(), lcp.data(), n);
+	}
+	return block_sorting_adaptive_from_lcp(rtext.data(), sa.data(), lcp.data(), n, nsegments);
+}
+
+//reverse sequence -> BWT -> LCP-driven optimal segmentation -> estimate entropy
+template<class T = long long>
+double block_sorting_estimator_adaptive(const std::vector<T> lattice) {
+	std::string sequence = int_vector_to_string<T>(lattice);
+	return block_sorting_estimator_adaptive(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size());
+}
+
 }
 #endif // #ifndef
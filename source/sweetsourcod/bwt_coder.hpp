@@ -0,0 +1,170 @@
+#ifndef SSC_BWT_CODER_H
+#define SSC_BWT_CODER_H
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <cstdint>
+
+#include "sweetsourcod/block_sorting.hpp"
+
+namespace ssc
+{
+
+// bzip2-like BWT compressor that only counts bits: BWT -> move-to-front -> zero run-length
+// (RUNA/RUNB bijective base-2 digits) -> entropy coder. No compressed bytes are produced.
+
+enum class BWTEntropyCoder { arithmetic, huffman };
+
+// move-to-front followed by bzip2's zero run-length encoding. Symbols of the output:
+// 0 = RUNA, 1 = RUNB, v + 1 for a nonzero MTF rank v, and sigma + 1 = end of block,
+// hence an alphabet of sigma + 2 symbols
+inline void mtf_zrle(const unsigned char* bwt, const size_t length, const size_t sigma, std::vector<uint16_t>& out) {
+	unsigned char order[256];
+	for (size_t i = 0; i < 256; ++i) order[i] = static_cast<unsigned char>(i);
+	out.clear();
+	size_t zero_run = 0;
+
+	auto flush_run = [&]() {
+		// bijective base 2: run = sum (digit_k + 1) 2^k with digit in {RUNA=0, RUNB=1}
+		while (zero_run > 0) {
+			--zero_run;
+			out.push_back(static_cast<uint16_t>(zero_run & 1));
+			zero_run >>= 1;
+		}
+	};
+
+	for (size_t i = 0; i < length; ++i) {
+		const unsigned char c = bwt[i];
+		if (order[0] == c) {
+			++zero_run;
+			continue;
+		}
+		flush_run();
+		size_t rank = 1;
+		unsigned char prev = order[0];
+		while (order[rank] != c) {
+			std::swap(prev, order[rank]);
+			++rank;
+		}
+		order[rank] = prev;
+		order[0] = c;
+		out.push_back(static_cast<uint16_t>(rank + 1));
+	}
+	flush_run();
+	out.push_back(static_cast<uint16_t>(sigma + 1));
+}
+
+// ideal code length of an adaptive order-0 arithmetic coder with periodic rescaling
+inline double adaptive_arithmetic_code_length(const std::vector<uint16_t>& symbols, const size_t alphabet) {
+	static const uint32_t increment = 32;
+	static const uint32_t limit = 1 << 16;
+	std::vector<uint32_t> freq(alphabet, 1);
+	uint32_t total = static_cast<uint32_t>(alphabet);
+	double bits = 0;
+
+	for (const auto& s : symbols) {
+		bits += std::log2(static_cast<double>(total) / freq[s]);
+		freq[s] += increment;
+		total += increment;
+		if (total > limit) {
+			total = 0;
+			for (auto& f : freq) {
+				f = (f + 1) / 2;
+				total += f;
+			}
+		}
+	}
+	return bits;
+}
+
+// code length of a static Huffman code for the symbols, including 5 bits per
+// alphabet entry for transmitting the code lengths as bzip2 does
+inline double huffman_code_length(const std::vector<uint16_t>& symbols, const size_t alphabet) {
+	std::vector<uint64_t> freq(alphabet, 0);
+	for (const auto& s : symbols) ++freq[s];
+
+	typedef std::pair<uint64_t, size_t> Item; // (weight, node)
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+	std::vector<size_t> parent;
+	for (size_t s = 0; s < alphabet; ++s) {
+		if (freq[s] > 0) {
+			heap.push({ freq[s], parent.size() });
+			parent.push_back(0);
+		}
+	}
+	const size_t nleaves = parent.size();
+	if (nleaves <= 1) {
+		return static_cast<double>(symbols.size() + 5 * alphabet);
+	}
+	while (heap.size() > 1) {
+		const Item a = heap.top(); heap.pop();
+		const Item b = heap.top(); heap.pop();
+		parent[a.second] = parent[b.second] = parent.size();
+		heap.push({ a.first + b.first, parent.size() });
+		parent.push_back(0);
+	}
+
+	// parents are created after their children, so depths resolve in reverse order
+	std::vector<size_t> depth(parent.size(), 0);
+	for (size_t k = parent.size() - 1; k-- > 0;) {
+		depth[k] = depth[parent[k]] + 1;
+	}
+	double bits = 5. * alphabet;
+	size_t leaf = 0;
+	for (size_t s = 0; s < alphabet; ++s) {
+		if (freq[s] > 0) {
+			bits += static_cast<double>(freq[s]) * depth[leaf++];
+		}
+	}
+	return bits;
+}
+
+// code length in bits of one block given its BWT, including the primary index.
+// symbols is scratch space for the MTF/RLE output, reused across blocks
+inline double bwt_block_code_length(const unsigned char* bwt, const size_t length, const size_t sigma,
+									const BWTEntropyCoder coder, std::vector<uint16_t>& symbols) {
+	mtf_zrle(bwt, length, sigma, symbols);
+	double bits = std::ceil(std::log2(static_cast<double>(length) + 1.));
+	if (coder == BWTEntropyCoder::arithmetic) {
+		bits += adaptive_arithmetic_code_length(symbols, sigma + 2);
+	}
+	else {
+		bits += huffman_code_length(symbols, sigma + 2);
+	}
+	return bits;
+}
+
+// total code length in bits of text compressed block by block (block_size = 0 means a single
+// block) with BWT + MTF + zero RLE + the chosen entropy coder, including the primary index
+inline double bwt_code_length(const unsigned char* text, const size_t length, const size_t block_size=0,
+							  const BWTEntropyCoder coder=BWTEntropyCoder::arithmetic) {
+	if (length == 0) { return 0; }
+	const size_t bs = (block_size == 0) ? length : std::min(block_size, length);
+	const size_t sigma = 1 + *std::max_element(text, text + length);
+	std::vector<unsigned char> bwt(bs);
+	std::vector<int> workspace(bs + 1);
+	std::vector<uint16_t> symbols;
+	symbols.reserve(bs + 1);
+	double bits = 0;
+
+	for (size_t start = 0; start < length; start += bs) {
+		const size_t n = std::min(bs, length - start);
+		burrows_wheeler_transform_into(text + start, n, bwt.data(), workspace.data());
+		bits += bwt_block_code_length(bwt.data(), n, sigma, coder, symbols);
+	}
+	return bits;
+}
+
+template<class T = long long>
+double bwt_code_length(const std::vector<T> lattice, const size_t block_size=0, const bool huffman=false) {
+	std::string sequence = int_vector_to_string<T>(lattice);
+	return bwt_code_length(reinterpret_cast<const unsigned char*>(sequence.data()), sequence.size(), block_size,
+						   huffman ? BWTEntropyCoder::huffman : BWTEntropyCoder::arithmetic);
+}
+
+}
+#endif // #ifndef
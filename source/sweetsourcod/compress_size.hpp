@@ -0,0 +1,648 @@
+#ifndef SSC_COMPRESS_SIZE_H
+#define SSC_COMPRESS_SIZE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sweetsourcod/bit_packing.hpp"
+#include "sweetsourcod/parallel.hpp"
+
+// codecs are compiled in when setup.py finds their headers, see find_codecs
+#ifdef SSC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SSC_HAVE_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef SSC_HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef SSC_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SSC_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace ssc
+{
+
+// Compressed sizes in bytes through the C libraries of the codecs of zipper_compress.py, with the
+// same settings (raw deflate with a 2^15 window and memLevel 9, lzma_alone with the bt4 match
+// finder and a 64 MiB dictionary, zstd without checksum and content size, brotli with
+// lgwin = lgblock = 24). Sizes are exact byte counts of the compressed streams.
+
+enum class CompressAlgorithm { deflate, bzip2, lzma, zstd, brotli, deflate_bzip2 };
+
+inline bool compress_algorithm_available(const CompressAlgorithm algorithm) {
+	switch (algorithm) {
+#ifdef SSC_HAVE_ZLIB
+	case CompressAlgorithm::deflate: return true;
+#endif
+#ifdef SSC_HAVE_BZIP2
+	case CompressAlgorithm::bzip2: return true;
+#endif
+#ifdef SSC_HAVE_LZMA
+	case CompressAlgorithm::lzma: return true;
+#endif
+#ifdef SSC_HAVE_ZSTD
+	case CompressAlgorithm::zstd: return true;
+#endif
+#ifdef SSC_HAVE_BROTLI
+	case CompressAlgorithm::brotli: return true;
+#endif
+#if defined(SSC_HAVE_ZLIB) && defined(SSC_HAVE_BZIP2)
+	case CompressAlgorithm::deflate_bzip2: return true;
+#endif
+	default: return false;
+	}
+}
+
+// highest compression level of each algorithm, the default "HIGHEST_PROTOCOL" of zipper_compress
+inline int compress_highest_level(const CompressAlgorithm algorithm) {
+	switch (algorithm) {
+	case CompressAlgorithm::zstd: return 22;
+	case CompressAlgorithm::brotli: return 11;
+	default: return 9;
+	}
+}
+
+// Compresses buffers with one algorithm and level, keeping the codec context (and the output
+// buffer of the caller) alive across calls so that iterated compression allocates only once
+class Compressor {
+	CompressAlgorithm m_algorithm;
+	int m_level;
+#ifdef SSC_HAVE_ZLIB
+	std::unique_ptr<z_stream> m_deflate;
+#endif
+#ifdef SSC_HAVE_LZMA
+	std::unique_ptr<lzma_stream> m_lzma;
+#endif
+#ifdef SSC_HAVE_ZSTD
+	ZSTD_CCtx* m_zstd;
+#endif
+	std::vector<unsigned char> m_stage;
+
+public:
+	Compressor(const CompressAlgorithm algorithm, const int level)
+		: m_algorithm(algorithm),
+		  m_level(level)
+#ifdef SSC_HAVE_ZSTD
+		  , m_zstd(NULL)
+#endif
+	{
+		if (!compress_algorithm_available(algorithm)) {
+			throw std::runtime_error("compression algorithm not available in this build");
+		}
+#ifdef SSC_HAVE_ZLIB
+		if (algorithm == CompressAlgorithm::deflate || algorithm == CompressAlgorithm::deflate_bzip2) {
+			m_deflate.reset(new z_stream());
+			if (deflateInit2(m_deflate.get(), level, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+				m_deflate.reset();
+				throw std::runtime_error("deflateInit2 failed");
+			}
+		}
+#endif
+#ifdef SSC_HAVE_LZMA
+		if (algorithm == CompressAlgorithm::lzma) {
+			const lzma_stream init = LZMA_STREAM_INIT;
+			m_lzma.reset(new lzma_stream(init));
+		}
+#endif
+#ifdef SSC_HAVE_ZSTD
+		if (algorithm == CompressAlgorithm::zstd) {
+			m_zstd = ZSTD_createCCtx();
+			if (m_zstd == NULL) { throw std::runtime_error("ZSTD_createCCtx failed"); }
+			ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_compressionLevel, level);
+			ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_checksumFlag, 0);
+			ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_contentSizeFlag, 0);
+		}
+#endif
+	}
+
+	~Compressor() {
+#ifdef SSC_HAVE_ZLIB
+		if (m_deflate) deflateEnd(m_deflate.get());
+#endif
+#ifdef SSC_HAVE_LZMA
+		if (m_lzma) lzma_end(m_lzma.get());
+#endif
+#ifdef SSC_HAVE_ZSTD
+		if (m_zstd != NULL) ZSTD_freeCCtx(m_zstd);
+#endif
+	}
+
+	Compressor(const Compressor&) = delete;
+	Compressor& operator=(const Compressor&) = delete;
+
+	// compress in[0..n-1] into out (resized to the compressed size), return the compressed size
+	size_t compress(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		switch (m_algorithm) {
+#ifdef SSC_HAVE_ZLIB
+		case CompressAlgorithm::deflate: return compress_deflate(in, n, out);
+#endif
+#ifdef SSC_HAVE_BZIP2
+		case CompressAlgorithm::bzip2: return compress_bzip2(in, n, out);
+#endif
+#ifdef SSC_HAVE_LZMA
+		case CompressAlgorithm::lzma: return compress_lzma(in, n, out);
+#endif
+#ifdef SSC_HAVE_ZSTD
+		case CompressAlgorithm::zstd: return compress_zstd(in, n, out);
+#endif
+#ifdef SSC_HAVE_BROTLI
+		case CompressAlgorithm::brotli: return compress_brotli(in, n, out);
+#endif
+#if defined(SSC_HAVE_ZLIB) && defined(SSC_HAVE_BZIP2)
+		case CompressAlgorithm::deflate_bzip2:
+			compress_deflate(in, n, m_stage);
+			return compress_bzip2(m_stage.data(), m_stage.size(), out);
+#endif
+		default: throw std::runtime_error("compression algorithm not available in this build");
+		}
+	}
+
+private:
+#ifdef SSC_HAVE_ZLIB
+	size_t compress_deflate(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		z_stream* zs = m_deflate.get();
+		if (n > UINT32_MAX / 2) { throw std::runtime_error("deflate input too large"); }
+		if (deflateReset(zs) != Z_OK) { throw std::runtime_error("deflateReset failed"); }
+		out.resize(deflateBound(zs, static_cast<uLong>(n)));
+		zs->next_in = const_cast<unsigned char*>(in);
+		zs->avail_in = static_cast<uInt>(n);
+		zs->next_out = out.data();
+		zs->avail_out = static_cast<uInt>(out.size());
+		if (deflate(zs, Z_FINISH) != Z_STREAM_END) { throw std::runtime_error("deflate failed"); }
+		out.resize(zs->total_out);
+		return out.size();
+	}
+#endif
+
+#ifdef SSC_HAVE_BZIP2
+	size_t compress_bzip2(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		// worst case of the bzip2 documentation: 1% larger plus 600 bytes
+		if (n > UINT32_MAX / 2) { throw std::runtime_error("bzip2 input too large"); }
+		out.resize(n + n / 100 + 601);
+		unsigned int size = static_cast<unsigned int>(out.size());
+		// bzip2 rejects a NULL source even when empty
+		char empty = 0;
+		const int status = BZ2_bzBuffToBuffCompress(reinterpret_cast<char*>(out.data()), &size,
+													 in ? const_cast<char*>(reinterpret_cast<const char*>(in)) : &empty,
+													 static_cast<unsigned int>(n), m_level, 0, 0);
+		if (status != BZ_OK) { throw std::runtime_error("BZ2_bzBuffToBuffCompress failed"); }
+		out.resize(size);
+		return out.size();
+	}
+#endif
+
+#ifdef SSC_HAVE_LZMA
+	size_t compress_lzma(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		lzma_options_lzma options;
+		if (lzma_lzma_preset(&options, static_cast<uint32_t>(m_level))) { throw std::runtime_error("invalid lzma level"); }
+		options.dict_size = 67108864;
+		options.lc = 3;
+		options.lp = 0;
+		options.pb = 2;
+		options.mode = LZMA_MODE_NORMAL;
+		options.mf = LZMA_MF_BT4;
+		options.nice_len = 273;
+		options.depth = 0;
+		// lzma_alone_encoder reinitializes the stream, reusing its allocations
+		lzma_stream* strm = m_lzma.get();
+		if (lzma_alone_encoder(strm, &options) != LZMA_OK) { throw std::runtime_error("lzma_alone_encoder failed"); }
+		out.resize(n + n / 2 + 4096);
+		strm->next_in = in;
+		strm->avail_in = n;
+		strm->next_out = out.data();
+		strm->avail_out = out.size();
+		lzma_ret status;
+		while ((status = lzma_code(strm, LZMA_FINISH)) == LZMA_OK) {
+			const size_t done = out.size() - strm->avail_out;
+			out.resize(2 * out.size());
+			strm->next_out = out.data() + done;
+			strm->avail_out = out.size() - done;
+		}
+		if (status != LZMA_STREAM_END) { throw std::runtime_error("lzma_code failed"); }
+		out.resize(out.size() - strm->avail_out);
+		return out.size();
+	}
+#endif
+
+#ifdef SSC_HAVE_ZSTD
+	size_t compress_zstd(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		out.resize(ZSTD_compressBound(n));
+		const size_t size = ZSTD_compress2(m_zstd, out.data(), out.size(), in, n);
+		if (ZSTD_isError(size)) { throw std::runtime_error(std::string("ZSTD_compress2 failed: ") + ZSTD_getErrorName(size)); }
+		out.resize(size);
+		return out.size();
+	}
+#endif
+
+#ifdef SSC_HAVE_BROTLI
+	size_t compress_brotli(const unsigned char* in, const size_t n, std::vector<unsigned char>& out) {
+		// an encoder instance serves a single stream
+		std::unique_ptr<BrotliEncoderState, void(*)(BrotliEncoderState*)> state(
+			BrotliEncoderCreateInstance(NULL, NULL, NULL), BrotliEncoderDestroyInstance);
+		if (!state) { throw std::runtime_error("BrotliEncoderCreateInstance failed"); }
+		BrotliEncoderSetParameter(state.get(), BROTLI_PARAM_MODE, BROTLI_MODE_GENERIC);
+		BrotliEncoderSetParameter(state.get(), BROTLI_PARAM_QUALITY, static_cast<uint32_t>(m_level));
+		BrotliEncoderSetParameter(state.get(), BROTLI_PARAM_LGWIN, 24);
+		BrotliEncoderSetParameter(state.get(), BROTLI_PARAM_LGBLOCK, 24);
+		out.resize(BrotliEncoderMaxCompressedSize(n) + 1024);
+		size_t avail_in = n, avail_out = out.size();
+		const uint8_t* next_in = in;
+		uint8_t* next_out = out.data();
+		if (!BrotliEncoderCompressStream(state.get(), BROTLI_OPERATION_FINISH, &avail_in, &next_in, &avail_out, &next_out, NULL)
+			|| !BrotliEncoderIsFinished(state.get())) {
+			throw std::runtime_error("BrotliEncoderCompressStream failed");
+		}
+		out.resize(out.size() - avail_out);
+		return out.size();
+	}
+#endif
+};
+
+struct IteratedCompression {
+	size_t size;       // smallest compressed size
+	size_t npasses;    // number of compressions giving it
+	size_t first_size; // size after a single compression
+};
+
+// Compress data[0..n-1], then keep compressing the output while its size decreases, as
+// get_comp_size_bytes_raw of zipper_compress.py. The codec context and two output buffers
+// are reused across passes
+inline IteratedCompression iterated_compressed_size(const unsigned char* data, const size_t n,
+													const CompressAlgorithm algorithm, const int level) {
+	Compressor compressor(algorithm, level);
+	std::vector<unsigned char> current, next;
+	IteratedCompression result;
+	result.first_size = result.size = compressor.compress(data, n, current);
+	result.npasses = 1;
+	while (compressor.compress(current.data(), current.size(), next) < result.size) {
+		result.size = next.size();
+		++result.npasses;
+		std::swap(current, next);
+	}
+	return result;
+}
+
+// Compressed sizes of the nrows rows of n symbols stored contiguously in rows, for each of the
+// nalgorithms (algorithms[a], levels[a]) pairs. Each row is packed once in its minimal binary
+// representation (as utils.get_mbr_bytes), then the nrows * nalgorithms compressions run on
+// nthreads threads (0 for the OpenMP default). Results are written row-major to
+// sizes[r * nalgorithms + a] (and npasses, first_sizes); iterate = false compresses once
+template<class T>
+void compressed_size_batch(const T* rows, const size_t nrows, const size_t n,
+						   const CompressAlgorithm* algorithms, const int* levels, const size_t nalgorithms,
+						   const bool iterate, size_t* sizes, size_t* npasses, size_t* first_sizes,
+						   const int nthreads = 0) {
+	for (size_t a = 0; a < nalgorithms; ++a) {
+		if (!compress_algorithm_available(algorithms[a])) {
+			throw std::runtime_error("compression algorithm not available in this build");
+		}
+	}
+	std::vector<std::vector<uint8_t>> packed(nrows);
+	parallel_for(nrows, nthreads, [&](const size_t r) {
+		const T* row = rows + r * n;
+		T largest = 0;
+		for (size_t i = 0; i < n; ++i) {
+			largest = std::max(largest, row[i]);
+		}
+		int nbits = 1;
+		while (nbits < 32 && (static_cast<uint64_t>(largest) >> nbits) != 0) ++nbits;
+		packed[r].resize(packed_size(n, nbits));
+		pack_bits(row, n, nbits, packed[r].data());
+	});
+	parallel_for(nrows * nalgorithms, nthreads, [&](const size_t job) {
+		const size_t r = job / nalgorithms, a = job % nalgorithms;
+		IteratedCompression result;
+		if (iterate) {
+			result = iterated_compressed_size(packed[r].data(), packed[r].size(), algorithms[a], levels[a]);
+		}
+		else {
+			std::vector<unsigned char> out;
+			Compressor compressor(algorithms[a], levels[a]);
+			result.size = result.first_size = compressor.compress(packed[r].data(), packed[r].size(), out);
+			result.npasses = 1;
+		}
+		sizes[job] = result.size;
+		npasses[job] = result.npasses;
+		first_sizes[job] = result.first_size;
+	});
+}
+
+// Streaming compression into a counting sink: the input is fed in chunks of any size through
+// update, the compressed stream goes through a fixed buffer of buffer_size bytes and only its
+// length is kept, so memory does not grow with the input (beyond the codec state, e.g. the
+// 64 MiB lzma dictionary). Chunking does not change the deflate, bzip2 and lzma streams, so the
+// count equals the size of Compressor::compress (brotli and zstd may differ slightly as their
+// encoders adapt to how the input arrives). A stage may forward its output to a next stage
+// instead (deflate+bzip2)
+class CompressionStage {
+protected:
+	std::vector<unsigned char> m_buffer;
+	std::unique_ptr<CompressionStage> m_next;
+	size_t m_count;
+
+	explicit CompressionStage(const size_t buffer_size)
+		: m_buffer(std::max<size_t>(buffer_size, 64)),
+		  m_count(0)
+	{}
+
+	void emit(const size_t k) {
+		if (m_next) {
+			m_next->update(m_buffer.data(), k);
+		}
+		else {
+			m_count += k;
+		}
+	}
+
+public:
+	virtual ~CompressionStage() {}
+	virtual void update(const unsigned char* in, size_t n) = 0;
+	// flush the stream and return the compressed size
+	virtual size_t finish() = 0;
+
+	void set_next(std::unique_ptr<CompressionStage> next) { m_next = std::move(next); }
+	size_t count() const { return m_next ? m_next->count() : m_count; }
+};
+
+// input chunks handed to 32 bit codec interfaces
+static const size_t compression_max_chunk = size_t(1) << 30;
+
+#ifdef SSC_HAVE_ZLIB
+class DeflateStage : public CompressionStage {
+	z_stream m_zs;
+
+	void run(const int flush) {
+		int status;
+		do {
+			m_zs.next_out = m_buffer.data();
+			m_zs.avail_out = static_cast<uInt>(m_buffer.size());
+			status = deflate(&m_zs, flush);
+			if (status == Z_STREAM_ERROR) { throw std::runtime_error("deflate failed"); }
+			emit(m_buffer.size() - m_zs.avail_out);
+		} while (m_zs.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+	}
+
+public:
+	DeflateStage(const int level, const size_t buffer_size)
+		: CompressionStage(buffer_size)
+	{
+		std::memset(&m_zs, 0, sizeof(m_zs));
+		if (deflateInit2(&m_zs, level, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+			throw std::runtime_error("deflateInit2 failed");
+		}
+	}
+	~DeflateStage() { deflateEnd(&m_zs); }
+
+	void update(const unsigned char* in, size_t n) override {
+		while (n > 0) {
+			const size_t chunk = std::min(n, compression_max_chunk);
+			m_zs.next_in = const_cast<unsigned char*>(in);
+			m_zs.avail_in = static_cast<uInt>(chunk);
+			run(Z_NO_FLUSH);
+			in += chunk;
+			n -= chunk;
+		}
+	}
+	size_t finish() override {
+		m_zs.avail_in = 0;
+		run(Z_FINISH);
+		if (m_next) m_next->finish();
+		return count();
+	}
+};
+#endif
+
+#ifdef SSC_HAVE_BZIP2
+class Bzip2Stage : public CompressionStage {
+	bz_stream m_bz;
+
+	void run(const int action) {
+		int status;
+		do {
+			m_bz.next_out = reinterpret_cast<char*>(m_buffer.data());
+			m_bz.avail_out = static_cast<unsigned int>(m_buffer.size());
+			status = BZ2_bzCompress(&m_bz, action);
+			if (status < 0) { throw std::runtime_error("BZ2_bzCompress failed"); }
+			emit(m_buffer.size() - m_bz.avail_out);
+		} while ((action == BZ_RUN) ? m_bz.avail_in > 0 : status != BZ_STREAM_END);
+	}
+
+public:
+	Bzip2Stage(const int level, const size_t buffer_size)
+		: CompressionStage(buffer_size)
+	{
+		std::memset(&m_bz, 0, sizeof(m_bz));
+		if (BZ2_bzCompressInit(&m_bz, level, 0, 0) != BZ_OK) { throw std::runtime_error("BZ2_bzCompressInit failed"); }
+	}
+	~Bzip2Stage() { BZ2_bzCompressEnd(&m_bz); }
+
+	void update(const unsigned char* in, size_t n) override {
+		while (n > 0) {
+			const size_t chunk = std::min(n, compression_max_chunk);
+			m_bz.next_in = const_cast<char*>(reinterpret_cast<const char*>(in));
+			m_bz.avail_in = static_cast<unsigned int>(chunk);
+			run(BZ_RUN);
+			in += chunk;
+			n -= chunk;
+		}
+	}
+	size_t finish() override {
+		m_bz.avail_in = 0;
+		run(BZ_FINISH);
+		if (m_next) m_next->finish();
+		return count();
+	}
+};
+#endif
+
+#ifdef SSC_HAVE_LZMA
+class LzmaStage : public CompressionStage {
+	lzma_stream m_strm;
+
+	void run(const lzma_action action) {
+		lzma_ret status;
+		do {
+			m_strm.next_out = m_buffer.data();
+			m_strm.avail_out = m_buffer.size();
+			status = lzma_code(&m_strm, action);
+			if (status != LZMA_OK && status != LZMA_STREAM_END) { throw std::runtime_error("lzma_code failed"); }
+			emit(m_buffer.size() - m_strm.avail_out);
+		} while ((action == LZMA_RUN) ? m_strm.avail_in > 0 : status != LZMA_STREAM_END);
+	}
+
+public:
+	LzmaStage(const int level, const size_t buffer_size)
+		: CompressionStage(buffer_size)
+	{
+		const lzma_stream init = LZMA_STREAM_INIT;
+		m_strm = init;
+		lzma_options_lzma options;
+		if (lzma_lzma_preset(&options, static_cast<uint32_t>(level))) { throw std::runtime_error("invalid lzma level"); }
+		options.dict_size = 67108864;
+		options.lc = 3;
+		options.lp = 0;
+		options.pb = 2;
+		options.mode = LZMA_MODE_NORMAL;
+		options.mf = LZMA_MF_BT4;
+		options.nice_len = 273;
+		options.depth = 0;
+		if (lzma_alone_encoder(&m_strm, &options) != LZMA_OK) { throw std::runtime_error("lzma_alone_encoder failed"); }
+	}
+	~LzmaStage() { lzma_end(&m_strm); }
+
+	void update(const unsigned char* in, const size_t n) override {
+		if (n == 0) return;
+		m_strm.next_in = in;
+		m_strm.avail_in = n;
+		run(LZMA_RUN);
+	}
+	size_t finish() override {
+		m_strm.avail_in = 0;
+		run(LZMA_FINISH);
+		if (m_next) m_next->finish();
+		return count();
+	}
+};
+#endif
+
+#ifdef SSC_HAVE_ZSTD
+class ZstdStage : public CompressionStage {
+	ZSTD_CCtx* m_cctx;
+
+	void run(ZSTD_inBuffer& input, const ZSTD_EndDirective mode) {
+		size_t remaining;
+		do {
+			ZSTD_outBuffer output = { m_buffer.data(), m_buffer.size(), 0 };
+			remaining = ZSTD_compressStream2(m_cctx, &output, &input, mode);
+			if (ZSTD_isError(remaining)) { throw std::runtime_error(std::string("ZSTD_compressStream2 failed: ") + ZSTD_getErrorName(remaining)); }
+			emit(output.pos);
+		} while ((mode == ZSTD_e_continue) ? input.pos < input.size : remaining != 0);
+	}
+
+public:
+	ZstdStage(const int level, const size_t buffer_size)
+		: CompressionStage(buffer_size),
+		  m_cctx(ZSTD_createCCtx())
+	{
+		if (m_cctx == NULL) { throw std::runtime_error("ZSTD_createCCtx failed"); }
+		ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level);
+		ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_checksumFlag, 0);
+		ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_contentSizeFlag, 0);
+	}
+	~ZstdStage() { ZSTD_freeCCtx(m_cctx); }
+
+	void update(const unsigned char* in, const size_t n) override {
+		if (n == 0) return;
+		ZSTD_inBuffer input = { in, n, 0 };
+		run(input, ZSTD_e_continue);
+	}
+	size_t finish() override {
+		ZSTD_inBuffer input = { NULL, 0, 0 };
+		run(input, ZSTD_e_end);
+		if (m_next) m_next->finish();
+		return count();
+	}
+};
+#endif
+
+#ifdef SSC_HAVE_BROTLI
+class BrotliStage : public CompressionStage {
+	BrotliEncoderState* m_state;
+
+	void run(const unsigned char* in, size_t n, const BrotliEncoderOperation operation) {
+		const uint8_t* next_in = in;
+		do {
+			size_t avail_out = m_buffer.size();
+			uint8_t* next_out = m_buffer.data();
+			if (!BrotliEncoderCompressStream(m_state, operation, &n, &next_in, &avail_out, &next_out, NULL)) {
+				throw std::runtime_error("BrotliEncoderCompressStream failed");
+			}
+			emit(m_buffer.size() - avail_out);
+		} while (n > 0 || BrotliEncoderHasMoreOutput(m_state)
+				 || (operation == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(m_state)));
+	}
+
+public:
+	BrotliStage(const int level, const size_t buffer_size)
+		: CompressionStage(buffer_size),
+		  m_state(BrotliEncoderCreateInstance(NULL, NULL, NULL))
+	{
+		if (m_state == NULL) { throw std::runtime_error("BrotliEncoderCreateInstance failed"); }
+		BrotliEncoderSetParameter(m_state, BROTLI_PARAM_MODE, BROTLI_MODE_GENERIC);
+		BrotliEncoderSetParameter(m_state, BROTLI_PARAM_QUALITY, static_cast<uint32_t>(level));
+		BrotliEncoderSetParameter(m_state, BROTLI_PARAM_LGWIN, 24);
+		BrotliEncoderSetParameter(m_state, BROTLI_PARAM_LGBLOCK, 24);
+	}
+	~BrotliStage() { BrotliEncoderDestroyInstance(m_state); }
+
+	void update(const unsigned char* in, const size_t n) override {
+		if (n == 0) return;
+		run(in, n, BROTLI_OPERATION_PROCESS);
+	}
+	size_t finish() override {
+		run(NULL, 0, BROTLI_OPERATION_FINISH);
+		if (m_next) m_next->finish();
+		return count();
+	}
+};
+#endif
+
+inline std::unique_ptr<CompressionStage> make_compression_stage(const CompressAlgorithm algorithm, const int level,
+																 const size_t buffer_size) {
+	if (!compress_algorithm_available(algorithm)) {
+		throw std::runtime_error("compression algorithm not available in this build");
+	}
+	std::unique_ptr<CompressionStage> stage;
+	switch (algorithm) {
+#ifdef SSC_HAVE_ZLIB
+	case CompressAlgorithm::deflate: stage.reset(new DeflateStage(level, buffer_size)); break;
+#endif
+#ifdef SSC_HAVE_BZIP2
+	case CompressAlgorithm::bzip2: stage.reset(new Bzip2Stage(level, buffer_size)); break;
+#endif
+#ifdef SSC_HAVE_LZMA
+	case CompressAlgorithm::lzma: stage.reset(new LzmaStage(level, buffer_size)); break;
+#endif
+#ifdef SSC_HAVE_ZSTD
+	case CompressAlgorithm::zstd: stage.reset(new ZstdStage(level, buffer_size)); break;
+#endif
+#ifdef SSC_HAVE_BROTLI
+	case CompressAlgorithm::brotli: stage.reset(new BrotliStage(level, buffer_size)); break;
+#endif
+#if defined(SSC_HAVE_ZLIB) && defined(SSC_HAVE_BZIP2)
+	case CompressAlgorithm::deflate_bzip2:
+		stage.reset(new DeflateStage(level, buffer_size));
+		stage->set_next(std::unique_ptr<CompressionStage>(new Bzip2Stage(level, buffer_size)));
+		break;
+#endif
+	default: throw std::runtime_error("compression algorithm not available in this build");
+	}
+	return stage;
+}
+
+// compressed size of data[0..n-1] measured through a counting sink, the input being fed to the
+// codec in chunks of chunk_size bytes
+inline size_t streaming_compressed_size(const unsigned char* data, const size_t n, const CompressAlgorithm algorithm,
+										const int level, const size_t chunk_size = size_t(1) << 20) {
+	std::unique_ptr<CompressionStage> stage = make_compression_stage(algorithm, level, size_t(1) << 16);
+	const size_t chunk = std::max<size_t>(chunk_size, 1);
+	for (size_t i = 0; i < n; i += chunk) {
+		stage->update(data + i, std::min(chunk, n - i));
+	}
+	return stage->finish();
+}
+
+}
+#endif // #ifndef
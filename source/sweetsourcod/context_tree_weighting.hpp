@@ -0,0 +1,141 @@
+#ifndef SSC_CONTEXT_TREE_WEIGHTING_H
+#define SSC_CONTEXT_TREE_WEIGHTING_H
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "sweetsourcod/lempel_ziv.hpp"
+
+namespace ssc{
+
+// log2(2^a + 2^b) without overflow
+inline double log2_add(const double a, const double b){
+    if (a < b){
+        return b + std::log2(1. + std::exp2(a - b));
+    }
+    return a + std::log2(1. + std::exp2(b - a));
+}
+
+// Context tree weighting (Willems, Shtarkov, Tjalkens 1995) with the multi-alphabet
+// Krichevsky-Trofimov estimator. Nodes live in a flat pool and are addressed by 32-bit
+// indices; the child of a node along a symbol and the count of a symbol in a node are found
+// in flat hash tables keyed on (node, symbol). Each lookup is O(1) expected whatever the
+// alphabet size, so an update costs O(depth), and only the contexts and symbols that
+// actually occur are ever allocated.
+class ContextTreeWeighting{
+    static const uint32_t nil = UINT32_MAX;
+
+    struct Node{
+        double log_pe;        // log2 of the KT estimate of the symbols seen in this context
+        double log_pw;        // log2 of the weighted probability
+        double sum_child_pw;  // sum of log2 Pw over the children
+        uint32_t total;       // number of symbols seen in this context
+    };
+
+    size_t m_depth;
+    size_t m_alphabet;
+    std::vector<Node> m_nodes;
+    std::unordered_map<uint64_t, uint32_t> m_children; // (node, symbol) -> child
+    std::unordered_map<uint64_t, uint32_t> m_counts;   // (node, symbol) -> count
+    std::vector<uint32_t> m_path;
+
+    static uint64_t key(const uint32_t node, const unsigned char symbol){
+        return (static_cast<uint64_t>(node) << 8) | symbol;
+    }
+
+    uint32_t new_node(){
+        if (m_nodes.size() >= nil){throw std::runtime_error("ContextTreeWeighting: node pool exhausted");}
+        m_nodes.push_back({0., 0., 0., 0});
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    uint32_t get_child(const uint32_t parent, const unsigned char symbol){
+        const auto inserted = m_children.emplace(key(parent, symbol), nil);
+        if (inserted.second){
+            inserted.first->second = new_node();
+        }
+        return inserted.first->second;
+    }
+
+    // returns the count of symbol in node and increments it
+    uint32_t fetch_increment(const uint32_t node, const unsigned char symbol){
+        return m_counts[key(node, symbol)]++;
+    }
+
+public:
+    ContextTreeWeighting(const size_t depth, const size_t alphabet)
+        : m_depth(depth),
+          m_alphabet(alphabet)
+    {
+        if (alphabet < 2 || alphabet > 256){throw std::runtime_error("ContextTreeWeighting: alphabet size must be in [2, 256]");}
+        m_path.resize(depth + 1);
+        new_node();
+    }
+
+    // code the symbol at position t of text, whose context are the depth preceding symbols
+    void update(const unsigned char* text, const size_t t){
+        const unsigned char x = text[t];
+        m_path[0] = 0;
+        for (size_t d=1; d<=m_depth; ++d){
+            m_path[d] = get_child(m_path[d - 1], text[t - d]);
+        }
+        double delta = 0.; // change in log2 Pw of the node below
+        for (size_t d=m_depth+1; d-- > 0;){
+            Node& node = m_nodes[m_path[d]];
+            const uint32_t cx = fetch_increment(m_path[d], x);
+            node.log_pe += std::log2(cx + .5) - std::log2(node.total + .5 * m_alphabet);
+            ++node.total;
+            const double old_pw = node.log_pw;
+            if (d == m_depth){
+                node.log_pw = node.log_pe;
+            }
+            else{
+                node.sum_child_pw += delta;
+                node.log_pw = log2_add(node.log_pe, node.sum_child_pw) - 1.;
+            }
+            delta = node.log_pw - old_pw;
+        }
+    }
+
+    // ideal code length in bits of all symbols coded so far
+    double code_length() const{
+        return -m_nodes[0].log_pw;
+    }
+
+    size_t nnodes() const{ return m_nodes.size(); }
+};
+
+// CTW ideal code length in bits of sequence, O(n depth) expected for alphabets up to 256.
+// The first depth symbols have no full context and are charged log2(alphabet) bits each.
+inline double ctw_code_length(const std::string& sequence, const size_t depth=8, size_t alphabet=0){
+    const size_t length = sequence.size();
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(sequence.data());
+    if (length == 0){
+        return 0.;
+    }
+    if (alphabet == 0){
+        alphabet = 1 + *std::max_element(text, text + length);
+    }
+    alphabet = std::max<size_t>(alphabet, 2);
+    if (length <= depth){
+        return length * std::log2((double) alphabet);
+    }
+    ContextTreeWeighting ctw(depth, alphabet);
+    for (size_t t=depth; t<length; ++t){
+        ctw.update(text, t);
+    }
+    return ctw.code_length() + depth * std::log2((double) alphabet);
+}
+
+template<class T=long long>
+double ctw_code_length(const std::vector<T> lattice, const size_t depth=8){
+    std::string sequence = int_vector_to_string<T>(lattice);
+    return ctw_code_length(sequence, depth);
+}
+
+}
+#endif // #ifndef
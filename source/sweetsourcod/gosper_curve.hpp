@@ -3,38 +3,20 @@
 
 #include <cmath>
 #include <algorithm>
-#include <memory>
 #include <stdexcept>
 #include <vector>
-#include <iterator>
-#include <random>
-#include <iostream>
+#include <cstddef>
 
+#include "sweetsourcod/parallel.hpp"
 
-namespace ssc 
+
+namespace ssc
 {
 
-static constexpr long double Pi = 3.14159265358979323846264338327950288L;
 static long double const factor = 1.0L / std::sqrt(7.0L);
-static long double const alpha = std::asin(std::sqrt(3.0L/7.0L) / 2.0L);
-static double const orientation[7] = { -Pi * 2.0/3.0, 0.0, 0.0, -Pi * 2.0/3.0, 0.0, Pi * 2.0/3.0, 0.0 };
-static bool   const idx_pattern[7] = { false, true, true, true, false, false, true };
-
-template <class T, class U>
-std::pair<T, U> operator+(const std::pair<T, U>& l, const std::pair<T, U>& r) {
-	return {l.first + r.first, l.second + r.second};
-}
-
-template <class T, class U>
-std::pair<T, U> operator-(const std::pair<T, U>& l, const std::pair<T, U>& r) {
-	return {l.first - r.first, l.second - r.second};
-}
-
-template <class T, class U, class V>
-std::pair<T, U> operator*(const V& l, const std::pair<T, U>& r) {
-	return {l * r.first, l * r.second};
-}
 
+// the distance along a level-n curve has n base-7 digits and must fit in a long long
+static const int gosper_max_level = 22;
 
 inline std::pair<double, double> hex_axial2xy(std::pair<int, int> ql, double size) {
 	return std::make_pair(size * (ql.first + ql.second/2.0) * std::sqrt(3.0),
@@ -63,107 +45,205 @@ inline std::pair<int, int> hex_xy2axial(std::pair<double, double> xy, double siz
 	else {
 		rz = -rx - ry;
 	}
-	
+
 	return std::make_pair(rx, rz);
 }
 
+// Exact integer formulation of the Gosper curve of doi:10.1109/CYBConf.2017.7985819.
+// The axial coordinates (q, r) of the hexagonal lattice are the Eisenstein integers q + r*zeta,
+// zeta = exp(i pi/3). Going up one level scales the lattice by sqrt(7) and rotates it by
+// -alpha, alpha = asin(sqrt(3/7)/2), i.e. multiplies it by beta = 3 - zeta (norm 7): a site z
+// of level i lies in the hexagon z' of level i-1 with z = beta z' + u, u one of the 7 minimal
+// residues {0, zeta^e}, e = 0..5, given by (q + 3r) mod 7 since zeta = 3 (mod beta).
+// The base-7 digit of level i is the position y of u relative to the current direction of
+// the curve (itself a unit zeta^e) up to a reflection pattern, all read from small tables.
+
+struct GosperSite {
+	long long q, r;
+};
+
+static const GosperSite gosper_unit[6] = { { 1, 0 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { 0, -1 }, { 1, -1 } };
+// residue (q + 3r) mod 7 -> unit index e of u, -1 for u = 0
+static const int gosper_residue_unit[7] = { -1, 0, 2, 1, 4, 5, 3 };
+// rotation (in units of pi/3) of u relative to the curve direction -> child position y, and back
+static const int gosper_child_position[6] = { 0, 5, 6, 3, 2, 1 };
+static const int gosper_child_rotation[7] = { 0, 5, 4, 3, 0, 1, 2 };
+// turn of the curve direction (in units of pi/3) after a child at position y
+static const int gosper_turn[7] = { 4, 0, 0, 4, 0, 2, 0 };
+static const bool idx_pattern[7] = { false, true, true, true, false, false, true };
+// direction (-1) and position of the level 0 hexagon
+static const int gosper_root_direction = 3;
+static const int gosper_root_position = 1;
+
+inline void check_gosper_level(const int n) {
+	if (n < 0) { throw std::runtime_error("recursion level of Gosper curve should not be negative"); }
+	if (n > gosper_max_level) { throw std::runtime_error("recursion level of Gosper curve should not exceed 22"); }
+}
 
-inline std::pair<double, double> rotate(double theta, std::pair<double, double> r) {
-	return std::make_pair(std::cos(theta)*r.first - std::sin(theta)*r.second,
-						  std::sin(theta)*r.first + std::cos(theta)*r.second);
+inline int gosper_mod7(const long long v) {
+	const int m = static_cast<int>(v % 7);
+	return (m < 0) ? m + 7 : m;
 }
 
-inline int get_y_idx(const std::pair<double, double> d_i, const std::pair<double, double> dy_i) {
-	double dot = dy_i.first*d_i.first  + dy_i.second*d_i.second;
-	double det = dy_i.first*d_i.second - dy_i.second*d_i.first;
-	double angle = std::atan2(det, dot);
-	int rd = std::lround(3.0*angle / Pi);
-	int y;
+// z * (2 + zeta) / 7, the exact quotient of z by beta when z = 0 (mod beta)
+inline GosperSite gosper_divide(const GosperSite z) {
+	return { (2 * z.q - z.r) / 7, (z.q + 3 * z.r) / 7 };
+}
 
-	if (std::hypot(dy_i.first, dy_i.second) < 0.01 * std::hypot(d_i.first, d_i.second)) {
-		y = 4;
+// beta * z
+inline GosperSite gosper_multiply(const GosperSite z) {
+	return { 3 * z.q + z.r, 2 * z.r - z.q };
+}
+
+// return distance along a level-n Gosper curve of the site with axial coordinates qr on
+// the lattice of hexagons of size factor^n, -1 if the site is not on the curve
+template<class T = long long>
+T gosper_axial2distance(const std::pair<int, int> qr, const int n) {
+	check_gosper_level(n);
+	int unit[gosper_max_level + 1];
+	GosperSite z = { qr.first, qr.second };
+	for (int i = n; i > 0; --i) {
+		const int e = gosper_residue_unit[gosper_mod7(z.q + 3 * z.r)];
+		unit[i] = e;
+		if (e >= 0) {
+			z.q -= gosper_unit[e].q;
+			z.r -= gosper_unit[e].r;
+		}
+		z = gosper_divide(z);
 	}
-	else if (rd ==  0) { y = 0; } 
-	else if (rd == -1) { y = 5; } 
-	else if (rd == -2) { y = 6; } 
-	else if (rd ==  1) { y = 1; } 
-	else if (rd ==  2) { y = 2; } 
-	else { y = 3; }
-
-	return y;
-}
-
-inline std::vector<std::pair<double, double>> gosper_center(const std::pair<double, double> pt, const int n) {
-	double s_i = std::pow(factor, n);
-	std::pair<double, double> cr_i = hex_axial2xy( hex_xy2axial(pt, s_i), s_i );
-	std::pair<double, double> c_i  = rotate(n*alpha, cr_i);
-	std::vector<std::pair<double, double>> center;
-
-	center.push_back(c_i);
-	for (int i = n - 1; i >= 0; --i) {
-		s_i /= factor;
-		cr_i = hex_axial2xy( hex_xy2axial( rotate(alpha, cr_i), s_i ), s_i );
-		c_i  = rotate(i*alpha, cr_i);
-		center.push_back(c_i);
+	if (z.q != 0 || z.r != 0) {
+		return -1;
 	}
-	std::reverse(center.begin(), center.end());
 
-	return center;
-}
-
-inline std::vector<int> gosper_index(const std::vector<std::pair<double, double>>& center, const int n) {
-	int k_i = 0, y_i = 1;
+	int direction = gosper_root_direction, y = gosper_root_position;
 	bool pattern = true;
-	std::pair<double, double> d_i  = std::make_pair(-std::sqrt(3.0), 0.0);
-	std::pair<double, double> dy_i = std::make_pair(0.0, 0.0);
-	std::vector<int> index;
-
-	if (std::abs(center[0].first) + std::abs(center[0].second) > 0.1) {
-		index.push_back(-1);
+	T distance = 0;
+	for (int i = 1; i <= n; ++i) {
+		direction = (direction + gosper_turn[y]) % 6;
+		y = (unit[i] < 0) ? 4 : gosper_child_position[(unit[i] - direction + 6) % 6];
+		const int k = pattern ? y : 6 - y;
+		pattern = pattern ? idx_pattern[y] : !idx_pattern[y];
+		distance = 7 * distance + k;
 	}
-	else {
-		index.push_back(k_i);
-		for (int i = 1; i <= n; ++i) {
-			d_i = factor * rotate(alpha, rotate(orientation[y_i], d_i));
-			dy_i = center[i] - center[i - 1];
-
-			y_i = get_y_idx(d_i, dy_i);
-			if (pattern) {
-				k_i = y_i;
-				pattern = idx_pattern[y_i];
-			}
-			else {
-				k_i = 6 - y_i;
-				pattern = !idx_pattern[y_i];
-			}
-
-			index.push_back(k_i);
-		}
-	}
-	
-	return index;
+	return distance;
 }
 
 // return distance along a level-n Gosper curve given input xy coordinates pt
 // algorithm from doi:10.1109/CYBConf.2017.7985819
 template<class T = long long>
 T gosper_coord2distance(const std::pair<double, double> pt, const int n) {
-	if (n < 0) { throw std::runtime_error("recursion level of Gosper curve should not be negative"); }
-	std::vector<std::pair<double, double>> center = gosper_center(pt, n);
-	std::vector<int> index = gosper_index(center, n);
-	T distance = 0, power7 = 1;
-	
-	if (index[0] == 0) {
-		for (size_t i = 0; i < index.size(); ++i) {
-			distance += index[n - i] * power7;
-			power7 *= 7;
+	check_gosper_level(n);
+	return gosper_axial2distance<T>(hex_xy2axial(pt, std::pow(factor, n)), n);
+}
+
+// distances of the npoints points (x, y) stored contiguously in points, written to distance,
+// parallel over blocks of points on nthreads threads (0 for the OpenMP default)
+template<class T = long long>
+void gosper_coord2distance(const double* points, const size_t npoints, const int n, T* distance, const int nthreads=0) {
+	check_gosper_level(n);
+	const double size = std::pow(factor, n);
+	const size_t block = 4096;
+	const size_t nblocks = (npoints + block - 1) / block;
+	parallel_for(nblocks, nthreads, [&](const size_t b) {
+		const size_t end = std::min(npoints, (b + 1) * block);
+		for (size_t i = b * block; i < end; ++i) {
+			distance[i] = gosper_axial2distance<T>(hex_xy2axial(std::make_pair(points[2 * i], points[2 * i + 1]), size), n);
 		}
+	});
+}
+
+// Inverse mapping: descend from the level 0 hexagon, each base-7 digit k selecting the child
+// z = beta z' + u of the current hexagon z' by the same direction and pattern rules
+struct GosperStep {
+	GosperSite site;
+	int direction;
+	int y;
+	bool pattern;
+};
+
+inline GosperStep gosper_root() {
+	return { { 0, 0 }, gosper_root_direction, gosper_root_position, true };
+}
+
+inline GosperStep gosper_child(const GosperStep& parent, const int k) {
+	GosperStep child;
+	child.direction = (parent.direction + gosper_turn[parent.y]) % 6;
+	child.y = parent.pattern ? k : 6 - k;
+	child.pattern = parent.pattern ? idx_pattern[child.y] : !idx_pattern[child.y];
+	child.site = gosper_multiply(parent.site);
+	if (child.y != 4) {
+		const GosperSite& u = gosper_unit[(child.direction + gosper_child_rotation[child.y]) % 6];
+		child.site.q += u.q;
+		child.site.r += u.r;
 	}
-	else {
-		distance = -1;
+	return child;
+}
+
+// return the axial coordinates, on the lattice of hexagons of size factor^n, of the site at
+// distance h along a level-n Gosper curve
+template<class T = long long>
+std::pair<int, int> gosper_distance2axial(const T h, const int n) {
+	check_gosper_level(n);
+	T power7 = 1;
+	for (int i = 0; i < n; ++i) power7 *= 7;
+	if (h < 0 || h >= power7) { throw std::runtime_error("Gosper distance out of range [0, 7^n)"); }
+	GosperStep step = gosper_root();
+	for (int i = 1; i <= n; ++i) {
+		power7 /= 7;
+		step = gosper_child(step, static_cast<int>((h / power7) % 7));
 	}
+	return std::make_pair(static_cast<int>(step.site.q), static_cast<int>(step.site.r));
+}
 
-	return distance;
+// return the xy coordinates (hexagon center) of the site at distance h along a level-n Gosper curve
+template<class T = long long>
+std::pair<double, double> gosper_distance2coord(const T h, const int n) {
+	return hex_axial2xy(gosper_distance2axial<T>(h, n), std::pow(factor, n));
+}
+
+inline void gosper_traversal(const GosperStep& step, const int level, const int n, int* axial, size_t& j) {
+	if (level == n) {
+		axial[2 * j] = static_cast<int>(step.site.q);
+		axial[2 * j + 1] = static_cast<int>(step.site.r);
+		++j;
+		return;
+	}
+	for (int k = 0; k < 7; ++k) {
+		gosper_traversal(gosper_child(step, k), level + 1, n, axial, j);
+	}
+}
+
+// write the axial coordinates (q, r) of the 7^n sites of the level-n Gosper curve, in curve
+// order, to axial[0..2*7^n-1]. Recursive descent in O(7^n), without sorting
+inline void gosper_traversal(const int n, int* axial) {
+	check_gosper_level(n);
+	size_t j = 0;
+	gosper_traversal(gosper_root(), 0, n, axial, j);
+}
+
+// Fill mask[0..7^n-1] with the flat indices (q - qmin) + (r - rmin) * boxv[0] of the sites of the
+// level-n Gosper curve in curve order, for a lattice stored on the bounding box boxv = {Lq, Lr}
+// of the axial coordinates of the patch, whose origin (qmin, rmin) is written to origin
+template<class I = long long>
+void gosper_mask(const int n, I* mask, size_t* boxv, int* origin) {
+	size_t nsites = 1;
+	for (int i = 0; i < n; ++i) nsites *= 7;
+	std::vector<int> axial(2 * nsites);
+	gosper_traversal(n, axial.data());
+	int qmin = axial[0], qmax = axial[0], rmin = axial[1], rmax = axial[1];
+	for (size_t j = 0; j < nsites; ++j) {
+		qmin = std::min(qmin, axial[2 * j]);
+		qmax = std::max(qmax, axial[2 * j]);
+		rmin = std::min(rmin, axial[2 * j + 1]);
+		rmax = std::max(rmax, axial[2 * j + 1]);
+	}
+	boxv[0] = qmax - qmin + 1;
+	boxv[1] = rmax - rmin + 1;
+	origin[0] = qmin;
+	origin[1] = rmin;
+	for (size_t j = 0; j < nsites; ++j) {
+		mask[j] = static_cast<I>((axial[2 * j] - qmin) + (axial[2 * j + 1] - rmin) * boxv[0]);
+	}
 }
 
 
@@ -0,0 +1,402 @@
+#ifndef SSC_HILBERT_CURVE_H
+#define SSC_HILBERT_CURVE_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace ssc
+{
+
+// Hilbert curve in N dimensions on the hypercube of side 2^p, after J. Skilling,
+// "Programming the Hilbert curve", AIP Conf. Proc. 707, 381 (2004).
+// Coordinates x[0..N-1] are p-bit integers; the distance h has N*p bits and is stored in
+// its "transpose" form, in which x[0] holds the most significant bit of every N-bit group.
+
+// in place, transpose -> axes
+inline void hilbert_transpose_to_axes(uint32_t* x, const int p, const int N) {
+	const uint32_t Z = uint32_t(2) << (p - 1);
+	// Gray decode by H ^ (H/2)
+	uint32_t t = x[N - 1] >> 1;
+	for (int i = N - 1; i > 0; --i) {
+		x[i] ^= x[i - 1];
+	}
+	x[0] ^= t;
+	// undo excess work
+	for (uint32_t Q = 2; Q != Z; Q <<= 1) {
+		const uint32_t P = Q - 1;
+		for (int i = N - 1; i >= 0; --i) {
+			if (x[i] & Q) {
+				x[0] ^= P; // invert
+			}
+			else {
+				t = (x[0] ^ x[i]) & P; // exchange
+				x[0] ^= t;
+				x[i] ^= t;
+			}
+		}
+	}
+}
+
+// in place, axes -> transpose
+inline void hilbert_axes_to_transpose(uint32_t* x, const int p, const int N) {
+	const uint32_t M = uint32_t(1) << (p - 1);
+	// inverse undo excess work
+	for (uint32_t Q = M; Q > 1; Q >>= 1) {
+		const uint32_t P = Q - 1;
+		for (int i = 0; i < N; ++i) {
+			if (x[i] & Q) {
+				x[0] ^= P;
+			}
+			else {
+				const uint32_t t = (x[0] ^ x[i]) & P;
+				x[0] ^= t;
+				x[i] ^= t;
+			}
+		}
+	}
+	// Gray encode
+	for (int i = 1; i < N; ++i) {
+		x[i] ^= x[i - 1];
+	}
+	uint32_t t = 0;
+	for (uint32_t Q = M; Q > 1; Q >>= 1) {
+		if (x[N - 1] & Q) {
+			t ^= Q - 1;
+		}
+	}
+	for (int i = 0; i < N; ++i) {
+		x[i] ^= t;
+	}
+}
+
+// Distances are N*p-bit integers of type H: uint64_t, or hilbert_uint128 where the compiler
+// provides 128-bit integers, which allows e.g. N = 4 dimensions at p = 32 or N = 16 at p = 8.
+static const int hilbert_max_dimensions = 16;
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 hilbert_uint128;
+#endif
+
+// bits of dimension j in the packed distance: positions k*N + (N-1-j), k = 0..p-1
+template<class H = uint64_t>
+H hilbert_dimension_mask(const int j, const int p, const int N) {
+	H m = 0;
+	for (int k = 0; k < p; ++k) {
+		m |= H(1) << (k * N + (N - 1 - j));
+	}
+	return m;
+}
+
+template<class H = uint64_t>
+H hilbert_pack_transpose(const uint32_t* x, const int p, const int N) {
+	H h = 0;
+	for (int k = p - 1; k >= 0; --k) {
+		for (int j = 0; j < N; ++j) {
+			h = (h << 1) | ((x[j] >> k) & 1);
+		}
+	}
+	return h;
+}
+
+template<class H = uint64_t>
+void hilbert_unpack_transpose(const H h, uint32_t* x, const int p, const int N) {
+	for (int j = 0; j < N; ++j) {
+		x[j] = 0;
+	}
+	for (int k = p - 1; k >= 0; --k) {
+		for (int j = 0; j < N; ++j) {
+			x[j] = (x[j] << 1) | static_cast<uint32_t>((h >> (k * N + (N - 1 - j))) & 1);
+		}
+	}
+}
+
+#if defined(__BMI2__)
+template<>
+inline uint64_t hilbert_pack_transpose<uint64_t>(const uint32_t* x, const int p, const int N) {
+	uint64_t h = 0;
+	for (int j = 0; j < N; ++j) {
+		h |= _pdep_u64(x[j], hilbert_dimension_mask<uint64_t>(j, p, N));
+	}
+	return h;
+}
+
+template<>
+inline void hilbert_unpack_transpose<uint64_t>(const uint64_t h, uint32_t* x, const int p, const int N) {
+	for (int j = 0; j < N; ++j) {
+		x[j] = static_cast<uint32_t>(_pext_u64(h, hilbert_dimension_mask<uint64_t>(j, p, N)));
+	}
+}
+#endif
+
+template<class H = uint64_t>
+void check_hilbert_parameters(const int p, const int N) {
+	if (N < 1 || p < 1) { throw std::runtime_error("Hilbert curve requires N >= 1 and p >= 1"); }
+	if (N > hilbert_max_dimensions) { throw std::runtime_error("Hilbert curve requires N <= 16"); }
+	if (p > 32 || N * p > static_cast<int>(8 * sizeof(H))) {
+		throw std::runtime_error("Hilbert curve requires p <= 32 and N * p <= number of bits of the distance type");
+	}
+}
+
+template<class H = uint64_t>
+H hilbert_distance_from_coordinates(const std::vector<uint32_t>& coordinates, const int p) {
+	const int N = static_cast<int>(coordinates.size());
+	check_hilbert_parameters<H>(p, N);
+	std::vector<uint32_t> x(coordinates);
+	hilbert_axes_to_transpose(x.data(), p, N);
+	return hilbert_pack_transpose<H>(x.data(), p, N);
+}
+
+template<class H = uint64_t>
+std::vector<uint32_t> hilbert_coordinates_from_distance(const H h, const int p, const int N) {
+	check_hilbert_parameters<H>(p, N);
+	std::vector<uint32_t> x(N);
+	hilbert_unpack_transpose<H>(h, x.data(), p, N);
+	hilbert_transpose_to_axes(x.data(), p, N);
+	return x;
+}
+
+// distances of up to 128 bits (64 without hilbert_uint128) split into 64-bit words (low, high), for
+// interfaces without 128-bit integers
+inline std::pair<uint64_t, uint64_t> hilbert_distance_from_coordinates_wide(const std::vector<uint32_t>& coordinates, const int p) {
+#if defined(__SIZEOF_INT128__)
+	const hilbert_uint128 h = hilbert_distance_from_coordinates<hilbert_uint128>(coordinates, p);
+	return std::pair<uint64_t, uint64_t>(static_cast<uint64_t>(h), static_cast<uint64_t>(h >> 64));
+#else
+	return std::pair<uint64_t, uint64_t>(hilbert_distance_from_coordinates<uint64_t>(coordinates, p), 0);
+#endif
+}
+
+inline std::vector<uint32_t> hilbert_coordinates_from_distance_wide(const uint64_t low, const uint64_t high, const int p, const int N) {
+#if defined(__SIZEOF_INT128__)
+	return hilbert_coordinates_from_distance<hilbert_uint128>((hilbert_uint128(high) << 64) | low, p, N);
+#else
+	if (high != 0) { throw std::runtime_error("Hilbert distances above 64 bits require 128-bit integer support"); }
+	return hilbert_coordinates_from_distance<uint64_t>(low, p, N);
+#endif
+}
+
+// Fill mask[0..n-1] for the hypercube of side 2^p using distances of type H, see hilbert_mask
+template<class H, class I>
+void hilbert_mask_impl(const std::vector<size_t>& boxv, const size_t n, const int p, I* mask) {
+	const int N = static_cast<int>(boxv.size());
+	check_hilbert_parameters<H>(p, N);
+	std::vector<size_t> stride(N, 1);
+	for (int d = 1; d < N; ++d) {
+		stride[d] = stride[d - 1] * boxv[d - 1];
+	}
+	std::vector<uint32_t> x(N);
+	H h = 0;
+
+	for (size_t j = 0; j < n;) {
+		hilbert_unpack_transpose<H>(h, x.data(), p, N);
+		hilbert_transpose_to_axes(x.data(), p, N);
+		// h starts an aligned block of 2^(N l) distances, which the curve spends in the
+		// sub-hypercube of side 2^l containing x. Find the largest such sub-hypercube that
+		// lies outside the box (its origin only grows as l decreases)
+		int l = 0;
+		while (l < p && (h & ((H(1) << (N * (l + 1) - 1) << 1) - 1)) == 0) ++l;
+		for (; l >= 0; --l) {
+			bool outside = false;
+			for (int d = 0; d < N; ++d) {
+				outside |= ((x[d] >> l) << l) >= boxv[d];
+			}
+			if (outside) break;
+		}
+		if (l >= 0) {
+			h += H(1) << (N * l);
+			continue;
+		}
+		size_t idx = 0;
+		for (int d = 0; d < N; ++d) {
+			idx += x[d] * stride[d];
+		}
+		mask[j++] = static_cast<I>(idx);
+		++h;
+	}
+}
+
+// Fill mask[0..prod(boxv)-1] with the flat indices (x[0] + x[1]*boxv[0] + ...) of the sites of
+// a box of side lengths boxv in the order of the Hilbert curve on the enclosing hypercube of
+// side 2^p. Sub-hypercubes that lie entirely outside the box are skipped as a whole, so the cost
+// is proportional to the number of sites rather than to the volume of the hypercube.
+// Any number of dimensions up to 16 is supported; distances are 64-bit when N*p <= 64
+// and 128-bit otherwise.
+template<class I = long long>
+void hilbert_mask(const std::vector<size_t>& boxv, I* mask) {
+	const int N = static_cast<int>(boxv.size());
+	size_t n = 1, L = 0;
+	for (const auto& side : boxv) {
+		n *= side;
+		L = std::max(L, side);
+	}
+	if (N == 0 || n == 0) { return; }
+	int p = 1;
+	while ((size_t(1) << p) < L) ++p;
+	if (N * p <= 64) {
+		hilbert_mask_impl<uint64_t, I>(boxv, n, p, mask);
+	}
+	else {
+#if defined(__SIZEOF_INT128__)
+		hilbert_mask_impl<hilbert_uint128, I>(boxv, n, p, mask);
+#else
+		check_hilbert_parameters<uint64_t>(p, N);
+#endif
+	}
+}
+
+template<class I = long long>
+std::vector<I> hilbert_mask(const std::vector<size_t>& boxv) {
+	size_t n = 1;
+	for (const auto& L : boxv) n *= L;
+	std::vector<I> mask(boxv.empty() ? 0 : n);
+	hilbert_mask<I>(boxv, mask.data());
+	return mask;
+}
+
+// Generalized ("pseudo") Hilbert curve for boxes of arbitrary side lengths, after the
+// recursive construction of J. Cervený (gilbert). It visits exactly the sites of the box,
+// in O(n). In 2D and for 3D boxes with even sides every step is to a nearest neighbour;
+// odd sides in 3D introduce a few short non-local steps.
+
+struct GilbertVec {
+	long long x, y, z;
+	GilbertVec operator+(const GilbertVec& o) const { return { x + o.x, y + o.y, z + o.z }; }
+	GilbertVec operator-(const GilbertVec& o) const { return { x - o.x, y - o.y, z - o.z }; }
+	GilbertVec operator-() const { return { -x, -y, -z }; }
+	long long length() const { return std::llabs(x + y + z); } // only one component is nonzero
+	GilbertVec unit() const { return { (x > 0) - (x < 0), (y > 0) - (y < 0), (z > 0) - (z < 0) }; }
+	GilbertVec half() const { return { floor_half(x), floor_half(y), floor_half(z) }; }
+	static long long floor_half(const long long v) { return (v >= 0) ? v / 2 : -((-v + 1) / 2); }
+};
+
+template<class I>
+class GilbertMask {
+	const size_t m_stride_y, m_stride_z;
+	I* m_mask;
+	size_t m_j;
+
+	void emit(const GilbertVec& p) {
+		m_mask[m_j++] = static_cast<I>(p.x + p.y * m_stride_y + p.z * m_stride_z);
+	}
+
+	void line(GilbertVec p, const GilbertVec& d, const long long n) {
+		for (long long i = 0; i < n; ++i) {
+			emit(p);
+			p = p + d;
+		}
+	}
+
+	// prefer even steps: make the half-length of v even unless v is short
+	static GilbertVec even_half(const GilbertVec& v) {
+		GilbertVec v2 = v.half();
+		if ((v2.length() % 2) && (v.length() > 2)) {
+			v2 = v2 + v.unit();
+		}
+		return v2;
+	}
+
+	void generate2d(const GilbertVec& p, const GilbertVec& a, const GilbertVec& b) {
+		const long long w = a.length(), h = b.length();
+		const GilbertVec da = a.unit(), db = b.unit();
+		if (h == 1) { line(p, da, w); return; }
+		if (w == 1) { line(p, db, h); return; }
+
+		GilbertVec a2 = a.half(), b2 = b.half();
+		if (2 * w > 3 * h) {
+			// long case: split in two parts only
+			a2 = even_half(a);
+			generate2d(p, a2, b);
+			generate2d(p + a2, a - a2, b);
+		}
+		else {
+			// standard case: one step up, one long horizontal, one step down
+			b2 = even_half(b);
+			generate2d(p, b2, a2);
+			generate2d(p + b2, a, b - b2);
+			generate2d(p + (a - da) + (b2 - db), -b2, -(a - a2));
+		}
+	}
+
+	void generate3d(const GilbertVec& p, const GilbertVec& a, const GilbertVec& b, const GilbertVec& c) {
+		const long long w = a.length(), h = b.length(), d = c.length();
+		const GilbertVec da = a.unit(), db = b.unit(), dc = c.unit();
+		if (h == 1 && d == 1) { line(p, da, w); return; }
+		if (w == 1 && d == 1) { line(p, db, h); return; }
+		if (w == 1 && h == 1) { line(p, dc, d); return; }
+
+		const GilbertVec a2 = even_half(a), b2 = even_half(b), c2 = even_half(c);
+		if (2 * w > 3 * h && 2 * w > 3 * d) {
+			// wide case, split in w only
+			generate3d(p, a2, b, c);
+			generate3d(p + a2, a - a2, b, c);
+		}
+		else if (3 * h > 4 * d) {
+			// do not split in d
+			generate3d(p, b2, c, a2);
+			generate3d(p + b2, a, b - b2, c);
+			generate3d(p + (a - da) + (b2 - db), -b2, c, -(a - a2));
+		}
+		else if (3 * d > 4 * h) {
+			// do not split in h
+			generate3d(p, c2, a2, b);
+			generate3d(p + c2, a, b, c - c2);
+			generate3d(p + (a - da) + (c2 - dc), -c2, -(a - a2), b);
+		}
+		else {
+			// regular case, split in all w/h/d
+			generate3d(p, b2, c2, a2);
+			generate3d(p + b2, c, a2, b - b2);
+			generate3d(p + (b2 - db) + (c - dc), a, -b2, -(c - c2));
+			generate3d(p + (a - da) + b2 + (c - dc), -c, -(a - a2), b - b2);
+			generate3d(p + (a - da) + (b2 - db), -b2, c2, -(a - a2));
+		}
+	}
+
+public:
+	GilbertMask(const std::vector<size_t>& boxv, I* mask)
+		: m_stride_y(boxv.size() > 1 ? boxv[0] : 0),
+		  m_stride_z(boxv.size() > 2 ? boxv[0] * boxv[1] : 0),
+		  m_mask(mask),
+		  m_j(0)
+	{
+		const long long W = boxv.size() > 0 ? boxv[0] : 0;
+		const long long H = boxv.size() > 1 ? boxv[1] : 1;
+		const long long D = boxv.size() > 2 ? boxv[2] : 1;
+		const GilbertVec o = { 0, 0, 0 };
+		if (W == 0 || H == 0 || D == 0) { return; }
+		if (boxv.size() <= 2) {
+			if (W >= H) { generate2d(o, { W, 0, 0 }, { 0, H, 0 }); }
+			else        { generate2d(o, { 0, H, 0 }, { W, 0, 0 }); }
+		}
+		else {
+			if (W >= H && W >= D)      { generate3d(o, { W, 0, 0 }, { 0, H, 0 }, { 0, 0, D }); }
+			else if (H >= W && H >= D) { generate3d(o, { 0, H, 0 }, { W, 0, 0 }, { 0, 0, D }); }
+			else                       { generate3d(o, { 0, 0, D }, { W, 0, 0 }, { 0, H, 0 }); }
+		}
+	}
+
+	size_t size() const { return m_j; }
+};
+
+// Fill mask[0..prod(boxv)-1] with the flat indices of the sites of a 1, 2 or 3 dimensional
+// box of arbitrary side lengths boxv in the order of the generalized Hilbert curve
+template<class I = long long>
+void pseudo_hilbert_mask(const std::vector<size_t>& boxv, I* mask) {
+	if (boxv.empty() || boxv.size() > 3) {
+		throw std::runtime_error("pseudo_hilbert_mask supports 1, 2 and 3 dimensional lattices");
+	}
+	GilbertMask<I> generator(boxv, mask);
+	(void) generator;
+}
+
+}
+#endif // #ifndef
@@ -3,6 +3,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -15,6 +16,9 @@
 
 #include "kkp/kkp.h"
 #include "kkp/divsufsort.h"
+#include "sweetsourcod/parallel.hpp"
+#include "sweetsourcod/scan_curves.hpp"
+#include "sweetsourcod/suffix_sort.hpp"
 
 namespace ssc
 {
@@ -101,14 +105,14 @@ size_t lempel_ziv_complexity76(const std::vector<T> lattice){
     return lempel_ziv_complexity76(sequence);
 }
 
-inline size_t lempel_ziv_complexity77_kkp(std::string& sequence, std::vector<std::pair<int, int>>* factorsp=NULL){
+inline size_t lempel_ziv_complexity77_kkp(std::string& sequence, std::vector<std::pair<int, int>>* factorsp=NULL, const int nthreads=1){
     // https://www.cs.helsinki.fi/group/pads/lz77.html#ref1
     // https://stackoverflow.com/questions/43631415/using-shared-ptr-with-char
     const int length = sequence.size();
     std::shared_ptr<unsigned char> text(new unsigned char[length], std::default_delete<unsigned char[]>());
     std::shared_ptr<int> sa(new int[length+2], std::default_delete<int[]>());
     memcpy(text.get(), sequence.c_str(), length);
-    divsufsort(text.get(), sa.get(), length);
+    suffix_sort(text.get(), sa.get(), length, nthreads);
     int nphrases = kkp2(text.get(), sa.get(), length, factorsp); //kkp3 has isssues with large arrays
     return nphrases;
 }
@@ -126,10 +130,10 @@ size_t lempel_ziv_complexity77_kkp(const std::vector<T> lattice){
 }
 
 template<class T=long long>
-std::vector<std::vector<int>> get_lz77_factors(const std::vector<T> lattice){
+std::vector<std::vector<int>> get_lz77_factors(const std::vector<T> lattice, const int nthreads=1){
     std::string sequence = int_vector_to_string<T>(lattice);
     std::vector<std::pair<int, int>> factors;
-    size_t nfactors = lempel_ziv_complexity77_kkp(sequence, &factors);
+    size_t nfactors = lempel_ziv_complexity77_kkp(sequence, &factors, nthreads);
     if (nfactors != factors.size()){throw std::runtime_error("nfactors and factors.size do no match");}
     std::vector<std::vector<int>> v;
     for (const auto &x : factors){
@@ -138,24 +142,200 @@ std::vector<std::vector<int>> get_lz77_factors(const std::vector<T> lattice){
     return v;
 }
 
+//sum of log2 of the factor positions and lengths, i.e. the compressed file size up to loglog corrections
+inline double factors_sumlog(const std::vector<std::pair<int, int>>& factors){
+    double sumlog = 0;
+    for (const auto &x : factors){
+        sumlog += std::log2(static_cast<double>(std::max(2, x.first))) + std::log2(static_cast<double>(std::max(2, x.second)));
+    }
+    return sumlog;
+}
+
 //returns complexity and compressed file size up to loglog corrections
 template<class T=long long>
-std::pair<size_t, double> lempel_ziv_complexity77_sumlog_kkp(const std::vector<T> lattice){
+std::pair<size_t, double> lempel_ziv_complexity77_sumlog_kkp(const std::vector<T> lattice, const int nthreads){
     std::string sequence = int_vector_to_string<T>(lattice);
     std::vector<std::pair<int, int>> factors;
-    size_t nfactors = lempel_ziv_complexity77_kkp(sequence, &factors);
+    size_t nfactors = lempel_ziv_complexity77_kkp(sequence, &factors, nthreads);
     if (nfactors != factors.size()){throw std::runtime_error("nfactors and factors.size do no match");}
-    double sumlog = 0;
-    for (const auto &x : factors){
-        sumlog += std::log2(static_cast<double>(std::max(2, x.first))) + std::log2(static_cast<double>(std::max(2, x.second)));
+    return std::pair<size_t, double>(nfactors, factors_sumlog(factors));
+}
+
+template<class T=long long>
+std::pair<size_t, double> lempel_ziv_complexity77_sumlog_kkp(const std::vector<T> lattice){
+    return lempel_ziv_complexity77_sumlog_kkp<T>(lattice, 1);
+}
+
+// LZ77 complexity and sumlog of text[0..n-1], suffix sorted on sort_threads threads (0 for the
+// OpenMP default, 1 inside parallel loops)
+inline void lz77_text_complexity(std::vector<unsigned char>& text, const int sort_threads,
+                                 size_t& nfactors, double& sumlog){
+    const int n = static_cast<int>(text.size());
+    std::vector<int> sa(text.size() + 2);
+    suffix_sort(text.data(), sa.data(), n, sort_threads);
+    std::vector<std::pair<int, int>> factors;
+    nfactors = kkp2(text.data(), sa.data(), n, &factors);
+    sumlog = factors_sumlog(factors);
+}
+
+template<class T>
+inline unsigned char lz77_text_symbol(const T x){
+    if (x < 0) {throw std::runtime_error("LZ77 complexity only accepts sequences of positive values");}
+    if (x > 255) {throw std::runtime_error("x>255, exceeded ascii table");}
+    return static_cast<unsigned char>(x);
+}
+
+// LZ77 complexity and sumlog of each of the nmembers lattices of n sites stored contiguously in
+// lattices. Sites are gathered in the scan order mask (raster order if mask is NULL) directly into
+// the text buffer of the factorizer. Members are factorized in parallel on nthreads threads
+// (0 for the OpenMP default); a single member instead uses the threads for its suffix sorting.
+template<class T, class I = long long>
+void lempel_ziv_complexity77_ensemble(const T* lattices, const size_t nmembers, const size_t n, const I* mask,
+                                      size_t* nfactors, double* sumlog, const int nthreads=0){
+    if (n > static_cast<size_t>(std::numeric_limits<int>::max() - 2)){throw std::runtime_error("lempel_ziv_complexity77_ensemble: lattice too large for divsufsort");}
+    auto factorize = [&](const size_t m, const int sort_threads){
+        const T* lattice = lattices + m * n;
+        std::vector<unsigned char> text(n);
+        for (size_t j=0; j<n; ++j){
+            text[j] = lz77_text_symbol(lattice[mask ? static_cast<size_t>(mask[j]) : j]);
+        }
+        lz77_text_complexity(text, sort_threads, nfactors[m], sumlog[m]);
+    };
+    if (nmembers == 1){
+        factorize(0, nthreads);
+        return;
     }
-    return std::pair<size_t, double>(nfactors, sumlog);
+    parallel_for(nmembers, nthreads, [&](const size_t m){ factorize(m, 1); });
+}
+
+// A symmetry of the box boxv (hyperoctahedral group restricted to permutations of axes of equal
+// length): axis d of the transformed lattice reads axis perm[d] of the original one, reversed
+// if bit d of flips is set
+struct LatticeSymmetry{
+    std::vector<int> perm;
+    unsigned flips;
+};
+
+// the symmetries of the box boxv, identity first: 2^N N! for a hypercube (8 in 2D, 48 in 3D)
+inline std::vector<LatticeSymmetry> lattice_symmetries(const std::vector<size_t>& boxv){
+    const int N = static_cast<int>(boxv.size());
+    if (N > 16){throw std::runtime_error("lattice_symmetries: at most 16 dimensions");}
+    std::vector<LatticeSymmetry> symmetries;
+    std::vector<int> perm(N);
+    for (int d=0; d<N; ++d) perm[d] = d;
+    do {
+        bool preserves_box = true;
+        for (int d=0; d<N; ++d){
+            preserves_box &= boxv[perm[d]] == boxv[d];
+        }
+        if (!preserves_box) continue;
+        for (unsigned flips=0; flips < (1u << N); ++flips){
+            symmetries.push_back({perm, flips});
+        }
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    return symmetries;
+}
+
+// LZ77 complexity and sumlog of the lattice of side lengths boxv transformed by each of its
+// lattice_symmetries and scanned in the order mask (raster order if mask is NULL), written to
+// nfactors[s] and sumlog[s]. The scan order of each symmetry is obtained from mask by index
+// arithmetic, so no transformed copy of the lattice is made. Symmetries are factorized in
+// parallel on nthreads threads (0 for the OpenMP default)
+template<class T, class I = long long>
+void lempel_ziv_complexity77_symmetries(const T* lattice, const std::vector<size_t>& boxv, const I* mask,
+                                        size_t* nfactors, double* sumlog, const int nthreads=0){
+    const int N = static_cast<int>(boxv.size());
+    size_t n = N > 0 ? 1 : 0;
+    for (const auto& L: boxv) n *= L;
+    if (n > static_cast<size_t>(std::numeric_limits<int>::max() - 2)){throw std::runtime_error("lempel_ziv_complexity77_symmetries: lattice too large for divsufsort");}
+    std::vector<size_t> stride(N, 1);
+    for (int d=1; d<N; ++d) stride[d] = stride[d - 1] * boxv[d - 1];
+    const std::vector<LatticeSymmetry> symmetries = lattice_symmetries(boxv);
+    parallel_for(symmetries.size(), nthreads, [&](const size_t s){
+        const LatticeSymmetry& g = symmetries[s];
+        // the flat index x[0] + x[1]*stride[1] + ... of the transformed lattice reads site
+        // sum_d y_d stride[perm[d]] of the lattice, y_d = x_d or L_d - 1 - x_d
+        std::vector<size_t> source_stride(N);
+        size_t base = 0;
+        for (int d=0; d<N; ++d){
+            source_stride[d] = stride[g.perm[d]];
+            if ((g.flips >> d) & 1){
+                base += (boxv[d] - 1) * source_stride[d];
+            }
+        }
+        std::vector<unsigned char> text(n);
+        for (size_t j=0; j<n; ++j){
+            size_t idx = mask ? static_cast<size_t>(mask[j]) : j;
+            size_t source = base;
+            for (int d=0; d<N; ++d){
+                const size_t x = idx % boxv[d];
+                idx /= boxv[d];
+                if ((g.flips >> d) & 1){
+                    source -= x * source_stride[d];
+                }
+                else{
+                    source += x * source_stride[d];
+                }
+            }
+            text[j] = lz77_text_symbol(lattice[source]);
+        }
+        lz77_text_complexity(text, 1, nfactors[s], sumlog[s]);
+    });
+}
+
+// LZ77 complexity and sumlog of the interlaced scan (see interlaced_scan) of nframes frames of
+// n sites, written directly into the text buffer of the factorizer. The suffix sorting runs on
+// nthreads threads (0 for the OpenMP default)
+template<class T, class I = long long>
+std::pair<size_t, double> lempel_ziv_complexity77_interlaced(const T* frames, const size_t nframes, const size_t n,
+                                                             const I* mask, const size_t block, const int nthreads=1){
+    if (nframes * n > static_cast<size_t>(std::numeric_limits<int>::max() - 2)){throw std::runtime_error("lempel_ziv_complexity77_interlaced: sequence too large for divsufsort");}
+    for (size_t i=0; i<nframes * n; ++i){
+        lz77_text_symbol(frames[i]);
+    }
+    std::vector<unsigned char> text(nframes * n);
+    interlaced_scan(frames, nframes, n, mask, block, text.data());
+    std::pair<size_t, double> result;
+    lz77_text_complexity(text, nthreads, result.first, result.second);
+    return result;
+}
+
+// per-site quantities of an LZ77 factorization: the code cost of the factor (as in
+// factors_sumlog) shared evenly among its symbols, the factor length or the factor index
+enum class LZ77FactorQuantity { cost, length, index };
+
+// Scatter a quantity of the LZ77 factors (position, length) of a scanned lattice back onto the
+// lattice in one O(n) pass: the j-th symbol of the sequence is written to field[mask[j]].
+// Literal factors have length 0 and cover one symbol. factors holds nfactors (position, length) pairs.
+template<class I = long long>
+void lz77_factor_field(const int* factors, const size_t nfactors, const I* mask, const size_t n,
+                       const LZ77FactorQuantity quantity, double* field){
+    size_t j = 0;
+    for (size_t f=0; f<nfactors; ++f){
+        const int position = factors[2 * f], length = factors[2 * f + 1];
+        const size_t span = std::max(1, length);
+        if (j + span > n){throw std::runtime_error("lz77_factor_field: factors cover more symbols than the mask");}
+        double value;
+        if (quantity == LZ77FactorQuantity::cost){
+            value = (std::log2(static_cast<double>(std::max(2, position))) + std::log2(static_cast<double>(std::max(2, length)))) / span;
+        }
+        else if (quantity == LZ77FactorQuantity::length){
+            value = static_cast<double>(span);
+        }
+        else{
+            value = static_cast<double>(f);
+        }
+        for (const size_t end = j + span; j < end; ++j){
+            field[mask[j]] = value;
+        }
+    }
+    if (j != n){throw std::runtime_error("lz77_factor_field: factors do not cover the mask");}
 }
 
 
 // Ziv-Merhav method for estimating relative entropy by cross parsing:
 
-inline size_t cross_parsing(std::string& sequence1, std::string& sequence2, std::vector<std::pair<int, int>>* factorsp=NULL) {
+inline size_t cross_parsing(std::string& sequence1, std::string& sequence2, std::vector<std::pair<int, int>>* factorsp=NULL, const int nthreads=1) {
     std::string sequence = sequence1 + char(0) + sequence2;
     const int length = sequence.size();
     std::shared_ptr<unsigned char> text(new unsigned char[length], std::default_delete<unsigned char[]>());
@@ -163,7 +343,7 @@ inline size_t cross_parsing(std::string& sequence1, std::string& sequence2, std:
     std::shared_ptr<int> isa(new int[length], std::default_delete<int[]>());
 
     memcpy(text.get(), sequence.c_str(), length);
-    divsufsort(text.get(), sa.get(), length);
+    suffix_sort(text.get(), sa.get(), length, nthreads);
     for (int i = 0; i < length; ++i) {
         isa.get()[sa.get()[i]] = i;
     }
@@ -213,11 +393,11 @@ size_t cross_parsing(const std::vector<T> lattice1, const std::vector<T> lattice
 }
 
 template<class T = long long>
-std::vector<std::vector<int>> get_cross_parsing_factors(const std::vector<T> lattice1, const std::vector<T> lattice2) {
+std::vector<std::vector<int>> get_cross_parsing_factors(const std::vector<T> lattice1, const std::vector<T> lattice2, const int nthreads=1) {
     std::string sequence1 = int_vector_to_string_cp<T>(lattice1);
     std::string sequence2 = int_vector_to_string_cp<T>(lattice2);
     std::vector<std::pair<int, int>> factors;
-    size_t nfactors = cross_parsing(sequence1, sequence2, &factors);
+    size_t nfactors = cross_parsing(sequence1, sequence2, &factors, nthreads);
     if (nfactors != factors.size()) { throw std::runtime_error("nfactors and factors.size do no match"); }
     std::vector<std::vector<int>> v;
     for (const auto& x : factors) {
@@ -227,17 +407,18 @@ std::vector<std::vector<int>> get_cross_parsing_factors(const std::vector<T> lat
 }
 
 template<class T = long long>
-std::pair<size_t, double> cross_parsing_complexity_sumlog(const std::vector<T> lattice1, const std::vector<T> lattice2) {
+std::pair<size_t, double> cross_parsing_complexity_sumlog(const std::vector<T> lattice1, const std::vector<T> lattice2, const int nthreads) {
     std::string sequence1 = int_vector_to_string_cp<T>(lattice1);
     std::string sequence2 = int_vector_to_string_cp<T>(lattice2);
     std::vector<std::pair<int, int>> factors;
-    size_t nfactors = cross_parsing(sequence1, sequence2, &factors);
+    size_t nfactors = cross_parsing(sequence1, sequence2, &factors, nthreads);
     if (nfactors != factors.size()) { throw std::runtime_error("nfactors and factors.size do no match"); }
-    double sumlog = 0;
-    for (const auto& x : factors) {
-        sumlog += std::log2(static_cast<double>(std::max(2, x.first))) + std::log2(static_cast<double>(std::max(2, x.second)));
-    }
-    return std::pair<size_t, double>(nfactors, sumlog);
+    return std::pair<size_t, double>(nfactors, factors_sumlog(factors));
+}
+
+template<class T = long long>
+std::pair<size_t, double> cross_parsing_complexity_sumlog(const std::vector<T> lattice1, const std::vector<T> lattice2) {
+    return cross_parsing_complexity_sumlog<T>(lattice1, lattice2, 1);
 }
 
 }
@@ -0,0 +1,92 @@
+#ifndef SSC_PARALLEL_H
+#define SSC_PARALLEL_H
+
+#include <cstddef>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace ssc
+{
+
+inline int get_max_threads(){
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// sets the number of OpenMP threads (used by the type B* suffix sorting in divsufsort and
+// divbwt) for the lifetime of the object and restores the previous value on destruction.
+// nthreads <= 0 keeps the current setting; without OpenMP this does nothing
+class ScopedNumThreads{
+    int m_previous;
+public:
+    explicit ScopedNumThreads(const int nthreads)
+        : m_previous(0)
+    {
+#ifdef _OPENMP
+        if (nthreads > 0){
+            m_previous = omp_get_max_threads();
+            omp_set_num_threads(nthreads);
+        }
+#else
+        (void) nthreads;
+#endif
+    }
+
+    ~ScopedNumThreads(){
+#ifdef _OPENMP
+        if (m_previous > 0){
+            omp_set_num_threads(m_previous);
+        }
+#endif
+    }
+
+    ScopedNumThreads(const ScopedNumThreads&) = delete;
+    ScopedNumThreads& operator=(const ScopedNumThreads&) = delete;
+};
+
+// calls f(i) for i in [0, n) on nthreads OpenMP threads (0 for the default) with dynamic
+// scheduling; the first exception thrown by f is rethrown once all iterations are done.
+// Nested parallel regions (e.g. divsufsort inside f) run on a single thread
+template<class F>
+void parallel_for(const size_t n, const int nthreads, F f){
+    std::exception_ptr error = nullptr;
+#ifdef _OPENMP
+    const int nt = (nthreads > 0) ? nthreads : omp_get_max_threads();
+    #pragma omp parallel for schedule(dynamic) num_threads(nt)
+    for (long long i=0; i<static_cast<long long>(n); ++i){
+        try{
+            f(static_cast<size_t>(i));
+        }
+        catch (...){
+            #pragma omp critical(ssc_parallel_for_error)
+            if (!error){
+                error = std::current_exception();
+            }
+        }
+    }
+#else
+    (void) nthreads;
+    for (size_t i=0; i<n; ++i){
+        try{
+            f(i);
+        }
+        catch (...){
+            if (!error){
+                error = std::current_exception();
+            }
+        }
+    }
+#endif
+    if (error){
+        std::rethrow_exception(error);
+    }
+}
+
+}
+#endif // #ifndef
@@ -0,0 +1,234 @@
+#ifndef SSC_RUN_LENGTH_H
+#define SSC_RUN_LENGTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace ssc
+{
+
+// Run-length encoding of sequences of non-negative integers over an unbounded alphabet.
+// The sequence becomes the pairs (symbol, run length), coded as
+//   varint: LEB128 bytes of symbol then of run, a byte stream that can be fed to any of the
+//           compressors or, having values in [0, 255], to the LZ77 factorizer
+//   elias_gamma / elias_delta: Elias code of symbol + 1 then of run, most significant bit
+//           first, the last byte padded with zero bits
+// rle_code_length gives the length in bits of the coded stream without writing it.
+
+enum class RLECoding { varint, elias_gamma, elias_delta };
+
+// the runs of seq[0..n-1]: calls f(symbol, run) for each maximal run
+template<class T, class F>
+void for_each_run(const T* seq, const size_t n, F f) {
+	size_t i = 0;
+	while (i < n) {
+		const T symbol = seq[i];
+		if (symbol < 0) { throw std::runtime_error("run-length encoding only accepts non-negative values"); }
+		size_t j = i + 1;
+		while (j < n && seq[j] == symbol) ++j;
+		f(static_cast<uint64_t>(symbol), static_cast<uint64_t>(j - i));
+		i = j;
+	}
+}
+
+inline int bit_length(uint64_t x) {
+	int b = 0;
+	while (x != 0) {
+		++b;
+		x >>= 1;
+	}
+	return b;
+}
+
+// length in bits of the code of x (x >= 1 for the Elias codes)
+inline size_t rle_value_bits(const uint64_t x, const RLECoding coding) {
+	switch (coding) {
+	case RLECoding::varint: {
+		const int b = bit_length(x);
+		return 8 * static_cast<size_t>(b == 0 ? 1 : (b + 6) / 7);
+	}
+	case RLECoding::elias_gamma:
+		return 2 * static_cast<size_t>(bit_length(x)) - 1;
+	case RLECoding::elias_delta: {
+		const int b = bit_length(x);
+		return static_cast<size_t>(b - 1) + 2 * static_cast<size_t>(bit_length(static_cast<uint64_t>(b))) - 1;
+	}
+	default: throw std::runtime_error("unknown run-length coding");
+	}
+}
+
+class BitWriter {
+	std::vector<uint8_t>& m_out;
+	uint64_t m_acc;
+	int m_bits;
+
+public:
+	explicit BitWriter(std::vector<uint8_t>& out)
+		: m_out(out),
+		  m_acc(0),
+		  m_bits(0)
+	{}
+
+	// write the nbits (<= 56) lowest bits of x, most significant first
+	void write(const uint64_t x, const int nbits) {
+		m_acc = (m_acc << nbits) | (x & ((uint64_t(1) << nbits) - 1));
+		m_bits += nbits;
+		while (m_bits >= 8) {
+			m_bits -= 8;
+			m_out.push_back(static_cast<uint8_t>(m_acc >> m_bits));
+		}
+	}
+
+	void write_bits(const uint64_t x, int nbits) {
+		while (nbits > 32) {
+			nbits -= 32;
+			write(x >> nbits, 32);
+		}
+		write(x, nbits);
+	}
+
+	void flush() {
+		if (m_bits > 0) {
+			m_out.push_back(static_cast<uint8_t>(m_acc << (8 - m_bits)));
+			m_bits = 0;
+		}
+	}
+};
+
+class BitReader {
+	const uint8_t* m_data;
+	size_t m_nbits;
+	size_t m_pos;
+
+public:
+	BitReader(const uint8_t* data, const size_t nbytes)
+		: m_data(data),
+		  m_nbits(8 * nbytes),
+		  m_pos(0)
+	{}
+
+	int read() {
+		if (m_pos >= m_nbits) { throw std::runtime_error("run-length stream truncated"); }
+		const int bit = (m_data[m_pos / 8] >> (7 - m_pos % 8)) & 1;
+		++m_pos;
+		return bit;
+	}
+
+	uint64_t read_bits(const int nbits) {
+		uint64_t x = 0;
+		for (int k = 0; k < nbits; ++k) {
+			x = (x << 1) | static_cast<uint64_t>(read());
+		}
+		return x;
+	}
+
+	// true when only zero padding is left: every code holds a 1 bit and padding is shorter than a byte
+	bool at_end() const {
+		if (m_nbits - m_pos >= 8) return false;
+		for (size_t p = m_pos; p < m_nbits; ++p) {
+			if ((m_data[p / 8] >> (7 - p % 8)) & 1) return false;
+		}
+		return true;
+	}
+};
+
+inline void write_varint(std::vector<uint8_t>& out, uint64_t x) {
+	while (x >= 0x80) {
+		out.push_back(static_cast<uint8_t>(x | 0x80));
+		x >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(x));
+}
+
+inline uint64_t read_varint(const uint8_t* data, const size_t nbytes, size_t& pos) {
+	uint64_t x = 0;
+	for (int shift = 0; ; shift += 7) {
+		if (pos >= nbytes) { throw std::runtime_error("run-length stream truncated"); }
+		if (shift > 63) { throw std::runtime_error("varint overflow in run-length stream"); }
+		const uint8_t byte = data[pos++];
+		x |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) return x;
+	}
+}
+
+inline void write_elias(BitWriter& writer, const uint64_t x, const RLECoding coding) {
+	const int b = bit_length(x);
+	if (coding == RLECoding::elias_gamma) {
+		writer.write_bits(0, b - 1);
+		writer.write_bits(x, b);
+		return;
+	}
+	// delta: gamma code of the bit length, then x without its leading 1
+	const int bb = bit_length(static_cast<uint64_t>(b));
+	writer.write_bits(0, bb - 1);
+	writer.write_bits(static_cast<uint64_t>(b), bb);
+	writer.write_bits(x, b - 1);
+}
+
+inline uint64_t read_elias(BitReader& reader, const RLECoding coding) {
+	int zeros = 0;
+	while (reader.read() == 0) {
+		if (++zeros > 63) { throw std::runtime_error("invalid Elias code in run-length stream"); }
+	}
+	const uint64_t head = (uint64_t(1) << zeros) | reader.read_bits(zeros);
+	if (coding == RLECoding::elias_gamma) return head;
+	if (head > 64) { throw std::runtime_error("invalid Elias code in run-length stream"); }
+	const int b = static_cast<int>(head);
+	return (uint64_t(1) << (b - 1)) | reader.read_bits(b - 1);
+}
+
+// coded (symbol, run) stream of seq[0..n-1]
+template<class T>
+std::vector<uint8_t> rle_encode(const T* seq, const size_t n, const RLECoding coding) {
+	std::vector<uint8_t> out;
+	if (coding == RLECoding::varint) {
+		for_each_run(seq, n, [&](const uint64_t symbol, const uint64_t run) {
+			write_varint(out, symbol);
+			write_varint(out, run);
+		});
+		return out;
+	}
+	BitWriter writer(out);
+	for_each_run(seq, n, [&](const uint64_t symbol, const uint64_t run) {
+		if (symbol == UINT64_MAX) { throw std::runtime_error("symbol too large for Elias coding"); }
+		write_elias(writer, symbol + 1, coding);
+		write_elias(writer, run, coding);
+	});
+	writer.flush();
+	return out;
+}
+
+// length in bits of rle_encode(seq, n, coding), padding excluded
+template<class T>
+size_t rle_code_length(const T* seq, const size_t n, const RLECoding coding) {
+	size_t bits = 0;
+	for_each_run(seq, n, [&](const uint64_t symbol, const uint64_t run) {
+		bits += rle_value_bits(coding == RLECoding::varint ? symbol : symbol + 1, coding) + rle_value_bits(run, coding);
+	});
+	return bits;
+}
+
+// (symbol, run) pairs of a coded stream
+inline void rle_decode_runs(const uint8_t* data, const size_t nbytes, const RLECoding coding,
+							std::vector<uint64_t>& symbols, std::vector<uint64_t>& runs) {
+	symbols.clear();
+	runs.clear();
+	if (coding == RLECoding::varint) {
+		size_t pos = 0;
+		while (pos < nbytes) {
+			symbols.push_back(read_varint(data, nbytes, pos));
+			runs.push_back(read_varint(data, nbytes, pos));
+		}
+		return;
+	}
+	BitReader reader(data, nbytes);
+	while (!reader.at_end()) {
+		symbols.push_back(read_elias(reader, coding) - 1);
+		runs.push_back(read_elias(reader, coding));
+	}
+}
+
+}
+#endif // #ifndef
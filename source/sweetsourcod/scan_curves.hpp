@@ -0,0 +1,303 @@
+#ifndef SSC_SCAN_CURVES_H
+#define SSC_SCAN_CURVES_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "sweetsourcod/hilbert_curve.hpp"
+
+namespace ssc
+{
+
+// Scan orders of lattices besides the Hilbert curve: Morton (Z-order), Peano and H-curve, and
+// a common entry point scan_mask for all the curves. Masks hold the flat indices
+// x[0] + x[1]*boxv[0] + ... of the sites of a box of side lengths boxv in scan order.
+
+enum class ScanCurve { raster, hilbert, pseudo_hilbert, morton, peano, h_curve };
+
+// Fill mask[0..n-1] for a curve on the hypercube of side base^p whose distances come in aligned
+// blocks of base^(N l) filling the sub-hypercubes of side base^l; decode(h, x) writes the
+// coordinates of distance h to x. Blocks entirely outside the box are skipped as a whole.
+template<class I, class Decode>
+void curve_mask_skipping(const std::vector<size_t>& boxv, const size_t n, const uint64_t base, const int p,
+						 Decode decode, I* mask) {
+	const int N = static_cast<int>(boxv.size());
+	std::vector<size_t> stride(N, 1);
+	for (int d = 1; d < N; ++d) {
+		stride[d] = stride[d - 1] * boxv[d - 1];
+	}
+	// side[l] = base^l, block[l] = base^(N l)
+	std::vector<uint64_t> side(p + 1, 1), block(p + 1, 1);
+	for (int l = 1; l <= p; ++l) {
+		side[l] = side[l - 1] * base;
+		block[l] = block[l - 1];
+		for (int d = 0; d < N; ++d) block[l] *= base;
+	}
+	std::vector<uint32_t> x(N);
+	uint64_t h = 0;
+
+	for (size_t j = 0; j < n;) {
+		decode(h, x.data());
+		int l = 0;
+		while (l < p && h % block[l + 1] == 0) ++l;
+		for (; l >= 0; --l) {
+			bool outside = false;
+			for (int d = 0; d < N; ++d) {
+				outside |= (x[d] / side[l]) * side[l] >= boxv[d];
+			}
+			if (outside) break;
+		}
+		if (l >= 0) {
+			h += block[l];
+			continue;
+		}
+		size_t idx = 0;
+		for (int d = 0; d < N; ++d) {
+			idx += x[d] * stride[d];
+		}
+		mask[j++] = static_cast<I>(idx);
+		++h;
+	}
+}
+
+// smallest p with base^p >= every side of boxv, and the number of sites
+inline int curve_level(const std::vector<size_t>& boxv, const size_t base, size_t& n) {
+	n = 1;
+	size_t L = 0;
+	for (const auto& side : boxv) {
+		n *= side;
+		L = std::max(L, side);
+	}
+	int p = 0;
+	for (size_t s = 1; s < L; s *= base) ++p;
+	return std::max(p, 1);
+}
+
+// Morton (Z-order): the distance interleaves the coordinate bits, dimension d holding
+// bits k*N + d, k = 0..p-1
+
+inline uint64_t morton_dimension_mask(const int d, const int p, const int N) {
+	uint64_t m = 0;
+	for (int k = 0; k < p; ++k) {
+		m |= uint64_t(1) << (k * N + d);
+	}
+	return m;
+}
+
+inline void morton_decode(const uint64_t h, uint32_t* x, const int p, const int N) {
+#if defined(__BMI2__)
+	for (int d = 0; d < N; ++d) {
+		x[d] = static_cast<uint32_t>(_pext_u64(h, morton_dimension_mask(d, p, N)));
+	}
+#else
+	for (int d = 0; d < N; ++d) {
+		x[d] = 0;
+	}
+	for (int k = 0; k < p; ++k) {
+		for (int d = 0; d < N; ++d) {
+			x[d] |= static_cast<uint32_t>((h >> (k * N + d)) & 1) << k;
+		}
+	}
+#endif
+}
+
+inline uint64_t morton_encode(const uint32_t* x, const int p, const int N) {
+	uint64_t h = 0;
+#if defined(__BMI2__)
+	for (int d = 0; d < N; ++d) {
+		h |= _pdep_u64(x[d], morton_dimension_mask(d, p, N));
+	}
+#else
+	for (int k = 0; k < p; ++k) {
+		for (int d = 0; d < N; ++d) {
+			h |= static_cast<uint64_t>((x[d] >> k) & 1) << (k * N + d);
+		}
+	}
+#endif
+	return h;
+}
+
+template<class I = long long>
+void morton_mask(const std::vector<size_t>& boxv, I* mask) {
+	const int N = static_cast<int>(boxv.size());
+	size_t n;
+	const int p = curve_level(boxv, 2, n);
+	if (N == 0 || n == 0) { return; }
+	if (N * p > 64) { throw std::runtime_error("Morton curve requires N * p <= 64"); }
+	curve_mask_skipping(boxv, n, 2, p, [p, N](const uint64_t h, uint32_t* x) { morton_decode(h, x, p, N); }, mask);
+}
+
+// Peano curve in N dimensions on the hypercube of side 3^p. The distance has base-3 digits
+// t_1 t_2 ... t_(N p), most significant first; digit k of coordinate d is t_((k-1)N+d+1),
+// replaced by 2 - t when the digits of the other coordinates preceding it sum to an odd number
+inline void peano_decode(uint64_t h, uint32_t* x, const int p, const int N) {
+	uint32_t digits[64];
+	const int nd = N * p;
+	for (int i = nd - 1; i >= 0; --i) {
+		digits[i] = static_cast<uint32_t>(h % 3);
+		h /= 3;
+	}
+	uint32_t parity_total = 0;
+	uint32_t parity[64];
+	for (int d = 0; d < N; ++d) {
+		x[d] = 0;
+		parity[d] = 0;
+	}
+	for (int i = 0; i < nd; ++i) {
+		const int d = i % N;
+		const uint32_t t = digits[i];
+		// parity of the digits of the other coordinates so far
+		const uint32_t flip = (parity_total ^ parity[d]) & 1;
+		x[d] = 3 * x[d] + (flip ? 2 - t : t);
+		parity[d] ^= t & 1;
+		parity_total ^= t & 1;
+	}
+}
+
+template<class I = long long>
+void peano_mask(const std::vector<size_t>& boxv, I* mask) {
+	const int N = static_cast<int>(boxv.size());
+	size_t n;
+	const int p = curve_level(boxv, 3, n);
+	if (N == 0 || n == 0) { return; }
+	if (N * p > 40) { throw std::runtime_error("Peano curve requires 3^(N * p) < 2^64, i.e. N * p <= 40"); }
+	curve_mask_skipping(boxv, n, 3, p, [p, N](const uint64_t h, uint32_t* x) { peano_decode(h, x, p, N); }, mask);
+}
+
+// H-curve (Niedermeier, Reinhardt, Sanders 2002) on the square of side 2^p: a closed curve
+// with unit steps that recursively halves right isosceles triangles, as the Sierpinski curve.
+// A cell whose center lies on a splitting diagonal goes to the side of its center displaced by
+// ((-1)^x, -(-1)^y) times an infinitesimal. Triangles then hold equal numbers of cells down
+// to two cells per triangle, which the last halving separates but not always into both
+// children, so the key below has 2p + 1 bits and takes 4^p of its 2^(2p+1) values: keys are
+// ordered along the curve but not contiguous. Computed exactly in doubled integer coordinates.
+inline uint64_t h_curve_key(const uint32_t x, const uint32_t y, const int p) {
+	typedef std::pair<long long, long long> Point;
+	const long long L = 2LL << p;
+	const Point c(2LL * x + 1, 2LL * y + 1);
+	const Point v((x & 1) ? -1 : 1, (y & 1) ? 1 : -1);
+	auto cross = [](const Point& a, const Point& b) { return a.first * b.second - a.second * b.first; };
+
+	long long s = c.first - c.second;
+	if (s == 0) s = v.first - v.second;
+	const bool first = s > 0;
+	Point P1 = first ? Point(0, 0) : Point(L, L);
+	Point P2 = first ? Point(L, 0) : Point(0, L);
+	Point P3 = first ? Point(L, L) : Point(0, 0);
+	uint64_t h = first ? 0 : 1;
+
+	for (int level = 1; level <= 2 * p; ++level) {
+		const Point M((P1.first + P3.first) / 2, (P1.second + P3.second) / 2);
+		const Point d(M.first - P2.first, M.second - P2.second);
+		long long side = cross(d, Point(c.first - P2.first, c.second - P2.second));
+		if (side == 0) side = cross(d, v);
+		const long long side1 = cross(d, Point(P1.first - P2.first, P1.second - P2.second));
+		// first child (P1, M, P2), second child (P2, M, P3)
+		if ((side > 0) == (side1 > 0)) {
+			P3 = P2;
+			P2 = M;
+			h <<= 1;
+		}
+		else {
+			P1 = P2;
+			P2 = M;
+			h = (h << 1) | 1;
+		}
+	}
+	return h;
+}
+
+template<class I = long long>
+void h_curve_mask(const std::vector<size_t>& boxv, I* mask) {
+	if (boxv.size() != 2) { throw std::runtime_error("H-curve requires a 2 dimensional lattice"); }
+	size_t n;
+	const int p = curve_level(boxv, 2, n);
+	if (n == 0) { return; }
+	if (p > 30) { throw std::runtime_error("H-curve requires sides <= 2^30"); }
+	const size_t L = size_t(1) << p;
+	if (boxv[0] == L && boxv[1] == L) {
+		// every other key is used: place the sites in a table of 2n slots and compact it
+		std::vector<long long> slot(2 * n, -1);
+		for (uint32_t y = 0; y < L; ++y) {
+			for (uint32_t x = 0; x < L; ++x) {
+				slot[h_curve_key(x, y, p)] = x + y * L;
+			}
+		}
+		size_t j = 0;
+		for (const auto& idx : slot) {
+			if (idx >= 0) mask[j++] = static_cast<I>(idx);
+		}
+		return;
+	}
+	std::vector<std::pair<uint64_t, size_t>> order;
+	order.reserve(n);
+	for (uint32_t y = 0; y < boxv[1]; ++y) {
+		for (uint32_t x = 0; x < boxv[0]; ++x) {
+			order.emplace_back(h_curve_key(x, y, p), x + y * boxv[0]);
+		}
+	}
+	std::sort(order.begin(), order.end());
+	for (size_t j = 0; j < n; ++j) {
+		mask[j] = static_cast<I>(order[j].second);
+	}
+}
+
+// Fill mask[0..prod(boxv)-1] with the flat indices of the sites of the box boxv in the order
+// of the chosen curve
+template<class I = long long>
+void scan_mask(const ScanCurve curve, const std::vector<size_t>& boxv, I* mask) {
+	switch (curve) {
+	case ScanCurve::raster: {
+		size_t n = boxv.empty() ? 0 : 1;
+		for (const auto& L : boxv) n *= L;
+		for (size_t j = 0; j < n; ++j) mask[j] = static_cast<I>(j);
+		break;
+	}
+	case ScanCurve::hilbert: hilbert_mask<I>(boxv, mask); break;
+	case ScanCurve::pseudo_hilbert: pseudo_hilbert_mask<I>(boxv, mask); break;
+	case ScanCurve::morton: morton_mask<I>(boxv, mask); break;
+	case ScanCurve::peano: peano_mask<I>(boxv, mask); break;
+	case ScanCurve::h_curve: h_curve_mask<I>(boxv, mask); break;
+	default: throw std::runtime_error("unknown scan curve");
+	}
+}
+
+template<class I = long long>
+std::vector<I> scan_mask(const ScanCurve curve, const std::vector<size_t>& boxv) {
+	size_t n = 1;
+	for (const auto& L : boxv) n *= L;
+	std::vector<I> mask(boxv.empty() ? 0 : n);
+	scan_mask<I>(curve, boxv, mask.data());
+	return mask;
+}
+
+// Interlace the scans of nframes frames of n sites stored contiguously in frames (frame t at
+// frames + t*n): blocks of block consecutive scan positions are taken from every frame in turn,
+// out = f_0[m_0..m_(B-1)] f_1[m_0..m_(B-1)] ... f_0[m_B..m_(2B-1)] ..., f_t[m_j] the site
+// mask[j] of frame t (site j if mask is NULL). block = 1 interlaces site by site, block = n
+// concatenates the scanned frames. Writes nframes*n values straight to out
+template<class T, class I, class O>
+void interlaced_scan(const T* frames, const size_t nframes, const size_t n, const I* mask, const size_t block, O* out) {
+	if (block == 0) { throw std::runtime_error("interlace block size must be positive"); }
+	size_t k = 0;
+	for (size_t j0 = 0; j0 < n; j0 += block) {
+		const size_t j1 = std::min(n, j0 + block);
+		for (size_t t = 0; t < nframes; ++t) {
+			const T* frame = frames + t * n;
+			for (size_t j = j0; j < j1; ++j) {
+				out[k++] = static_cast<O>(frame[mask ? static_cast<size_t>(mask[j]) : j]);
+			}
+		}
+	}
+}
+
+}
+#endif // #ifndef
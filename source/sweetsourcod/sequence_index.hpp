@@ -0,0 +1,201 @@
+#ifndef SSC_SEQUENCE_INDEX_H
+#define SSC_SEQUENCE_INDEX_H
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+#include "kkp/kkp.h"
+#include "kkp/divsufsort.h"
+#include "sweetsourcod/parallel.hpp"
+#include "sweetsourcod/suffix_sort.hpp"
+#include "sweetsourcod/lempel_ziv.hpp"
+#include "sweetsourcod/block_sorting.hpp"
+#include "sweetsourcod/bwt_coder.hpp"
+#include "sweetsourcod/context_tree_weighting.hpp"
+
+namespace ssc{
+
+// One sequence, converted to bytes once, with the suffix array built once and the
+// derived structures (ISA, LCP, reversed suffix array, BWT, LZ77 factors) built lazily
+// on first use, so that computing several estimators does not repeat the work.
+// The block-sorting estimators group symbols by their preceding context and therefore
+// need the suffix array of the reversed sequence, which is a second (lazy) suffix sort.
+class SequenceIndex{
+    std::string m_text;
+    int m_n;
+    int m_nthreads;
+    std::vector<int> m_sa;
+    std::vector<int> m_isa;
+    std::vector<int> m_lcp;
+    std::vector<unsigned char> m_rtext;
+    std::vector<int> m_rsa;
+    std::vector<int> m_rlcp;
+    std::vector<unsigned char> m_bwt;
+    std::vector<std::pair<int, int>> m_lz77_factors;
+    bool m_has_lz77;
+
+    const unsigned char* text() const{
+        return reinterpret_cast<const unsigned char*>(m_text.data());
+    }
+
+    void build_reversed(){
+        if (!m_rsa.empty() || m_n == 0){
+            return;
+        }
+        m_rtext.assign(m_text.rbegin(), m_text.rend());
+        m_rsa.resize(m_n);
+        suffix_sort(m_rtext.data(), m_rsa.data(), m_n, m_nthreads);
+    }
+
+public:
+    // nthreads > 0 sets the number of threads of the suffix sorting
+    SequenceIndex(const std::string& sequence, const int nthreads=1)
+        : m_text(sequence),
+          m_n(0),
+          m_nthreads(nthreads),
+          m_has_lz77(false)
+    {
+        if (sequence.size() > static_cast<size_t>(std::numeric_limits<int>::max())){
+            throw std::runtime_error("SequenceIndex: sequence too long for divsufsort");
+        }
+        m_n = static_cast<int>(sequence.size());
+        m_sa.resize(m_n + 2);
+        suffix_sort(text(), m_sa.data(), m_n, m_nthreads);
+    }
+
+    template<class T=long long>
+    SequenceIndex(const std::vector<T> lattice, const int nthreads=1)
+        : SequenceIndex(int_vector_to_string<T>(lattice), nthreads)
+    {}
+
+    size_t size() const{ return m_n; }
+
+    const std::string& sequence() const{ return m_text; }
+
+    const std::vector<int>& suffix_array() const{ return m_sa; }
+
+    const std::vector<int>& inverse_suffix_array(){
+        if (m_isa.empty() && m_n > 0){
+            m_isa.resize(m_n);
+            for (int i=0; i<m_n; ++i){
+                m_isa[m_sa[i]] = i;
+            }
+        }
+        return m_isa;
+    }
+
+    const std::vector<int>& lcp_array(){
+        if (m_lcp.empty() && m_n > 0){
+            m_lcp.resize(m_n);
+            std::vector<int> isa(m_n);
+            lcp_array_kasai(text(), m_sa.data(), isa.data(), m_lcp.data(), m_n);
+            if (m_isa.empty()){
+                m_isa.swap(isa);
+            }
+        }
+        return m_lcp;
+    }
+
+    // Burrows-Wheeler transform of the reversed sequence, as burrows_wheeler_transform
+    const std::vector<unsigned char>& bwt(){
+        if (m_bwt.empty() && m_n > 0){
+            build_reversed();
+            m_bwt.resize(m_n);
+            bwt_from_suffix_array(m_rtext.data(), m_rsa.data(), m_n, m_bwt.data());
+        }
+        return m_bwt;
+    }
+
+    const std::vector<std::pair<int, int>>& lz77_factors(){
+        if (!m_has_lz77){
+            kkp2(const_cast<unsigned char*>(text()), m_sa.data(), m_n, &m_lz77_factors);
+            m_has_lz77 = true;
+        }
+        return m_lz77_factors;
+    }
+
+    std::pair<size_t, double> lempel_ziv_complexity77(){
+        const std::vector<std::pair<int, int>>& factors = lz77_factors();
+        return std::pair<size_t, double>(factors.size(), factors_sumlog(factors));
+    }
+
+    size_t lempel_ziv_complexity76() const{
+        return ssc::lempel_ziv_complexity76(m_text);
+    }
+
+    size_t lempel_ziv_complexity78() const{
+        return ssc::lempel_ziv_complexity78(m_text);
+    }
+
+    // Shannon entropy of the blocks of length blocksize, same as block_entropy_cpp. Blocks
+    // are the runs of suffixes (of length >= blocksize) whose pairwise LCP is >= blocksize
+    double block_entropy(const size_t blocksize=6){
+        if (blocksize == 0 || blocksize > size()){throw std::runtime_error("SequenceIndex: blocksize must be in [1, n]");}
+        const std::vector<int>& lcp = lcp_array();
+        const int k = static_cast<int>(blocksize);
+        const double nblocks = m_n - k + 1;
+        double ent = 0.;
+        size_t count = 0;
+        int run_min = std::numeric_limits<int>::max();
+
+        for (int i=0; i<m_n; ++i){
+            if (i > 0){
+                run_min = std::min(run_min, lcp[i]);
+            }
+            if (m_sa[i] > m_n - k){
+                continue;
+            }
+            if (count > 0 && run_min < k){
+                const double p = count / nblocks;
+                ent -= p * std::log2(p);
+                count = 0;
+            }
+            ++count;
+            run_min = std::numeric_limits<int>::max();
+        }
+        const double p = count / nblocks;
+        ent -= p * std::log2(p);
+        return ent;
+    }
+
+    double block_sorting_estimator_uniform(){
+        const std::vector<unsigned char>& b = bwt();
+        return block_sorting_uniform_from_bwt(b.data(), b.size());
+    }
+
+    double block_sorting_estimator_adaptive(){
+        if (m_n == 0){
+            return 0;
+        }
+        build_reversed();
+        if (m_rlcp.empty()){
+            m_rlcp.resize(m_n);
+            std::vector<int> isa(m_n);
+            lcp_array_kasai(m_rtext.data(), m_rsa.data(), isa.data(), m_rlcp.data(), m_n);
+        }
+        return block_sorting_adaptive_from_lcp(m_rtext.data(), m_rsa.data(), m_rlcp.data(), m_n);
+    }
+
+    // single-block BWT + MTF + zero RLE code length, reusing the cached BWT
+    double bwt_code_length(const bool huffman=false){
+        if (m_n == 0){
+            return 0;
+        }
+        const std::vector<unsigned char>& b = bwt();
+        const size_t sigma = 1 + *std::max_element(text(), text() + m_n);
+        std::vector<uint16_t> symbols;
+        symbols.reserve(m_n + 1);
+        return ssc::bwt_block_code_length(b.data(), m_n, sigma, huffman ? BWTEntropyCoder::huffman : BWTEntropyCoder::arithmetic, symbols);
+    }
+
+    double ctw_code_length(const size_t depth=8) const{
+        return ssc::ctw_code_length(m_text, depth);
+    }
+};
+
+}
+#endif // #ifndef
@@ -0,0 +1,284 @@
+#ifndef SSC_SUFFIX_SORT_H
+#define SSC_SUFFIX_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "kkp/divsufsort.h"
+#include "sweetsourcod/parallel.hpp"
+
+namespace ssc{
+
+// parallel DC3 does about three times the work of divsufsort, so it is used from this many
+// threads and for texts at least this long; below, divsufsort runs with its OpenMP type B* sort
+static const int parallel_suffix_sort_min_threads = 4;
+static const int parallel_suffix_sort_min_length = 1 << 16;
+
+inline int suffix_sort_bits(uint64_t x){
+    int b = 0;
+    while (x != 0){
+        ++b;
+        x >>= 1;
+    }
+    return b;
+}
+
+// [0, n) split in nchunks contiguous chunks, one parallel_for task per chunk; begin(c) and
+// end(c) bound chunk c
+struct SuffixSortChunks{
+    size_t n, nchunks, chunk;
+    int nthreads;
+
+    SuffixSortChunks(const size_t n_, const int nthreads_)
+        : n(n_),
+          nchunks(std::max<size_t>(1, std::min<size_t>(n_, static_cast<size_t>(std::max(nthreads_, 1))))),
+          chunk((n_ + nchunks - 1) / nchunks),
+          nthreads(nthreads_)
+    {}
+
+    size_t begin(const size_t c) const{ return std::min(n, c * chunk); }
+    size_t end(const size_t c) const{ return std::min(n, (c + 1) * chunk); }
+
+    template<class F>
+    void run(F f) const{
+        parallel_for(nchunks, nthreads, f);
+    }
+};
+
+// stable LSD radix sort of b[0..n-1] = a[0..n-1] by the keys key[a[i]] in [0, K], in the
+// fewest passes of at most 12 bit digits: per-chunk digit histograms and scatters run in
+// parallel, the offsets (digit-major, then chunk) are a serial scan of the chunk histograms.
+// a is used as scratch
+inline void radix_pass(int* a, int* b, const int* key, const size_t n, const int K, const int nthreads){
+    const SuffixSortChunks chunks(n, nthreads);
+    const int bits = std::max(1, suffix_sort_bits(static_cast<uint64_t>(K)));
+    const int npasses = (bits + 11) / 12;
+    const int digit_bits = (bits + npasses - 1) / npasses;
+    const size_t radix = size_t(1) << digit_bits;
+    const int mask = static_cast<int>(radix - 1);
+    std::vector<size_t> offsets(radix * chunks.nchunks);
+    int* from = a;
+    int* to = b;
+    for (int pass=0; pass<npasses; ++pass){
+        const int shift = digit_bits * pass;
+        chunks.run([&](const size_t c){
+            size_t* count = &offsets[radix * c];
+            std::fill(count, count + radix, 0);
+            for (size_t i=chunks.begin(c); i<chunks.end(c); ++i){
+                ++count[(key[from[i]] >> shift) & mask];
+            }
+        });
+        size_t sum = 0;
+        for (size_t d=0; d<radix; ++d){
+            for (size_t c=0; c<chunks.nchunks; ++c){
+                const size_t count = offsets[radix * c + d];
+                offsets[radix * c + d] = sum;
+                sum += count;
+            }
+        }
+        chunks.run([&](const size_t c){
+            size_t* next = &offsets[radix * c];
+            for (size_t i=chunks.begin(c); i<chunks.end(c); ++i){
+                to[next[(key[from[i]] >> shift) & mask]++] = from[i];
+            }
+        });
+        std::swap(from, to);
+    }
+    if (from != b){
+        std::copy(from, from + n, b);
+    }
+}
+
+// Parallel DC3 (skew) suffix sorting of Karkkainen and Sanders: sa[0..n-1] of s[0..n-1], with
+// s[i] in [1, K] and s[n] = s[n+1] = s[n+2] = 0. The suffixes at positions i mod 3 != 0 are
+// sorted by radix sorting their triples and, when triples repeat, recursively on the string of
+// triple names (2n/3 symbols); the suffixes at i mod 3 == 0 follow from one more radix pass and
+// both sets are merged. Radix passes, naming and compactions run over chunks in parallel and the
+// merge is split by co-ranking, so all O(n) work is parallel except the O(nthreads) scans
+inline void dc3_suffix_sort(const int* s, int* sa, const int n, const int K, const int nthreads){
+    if (n == 1){
+        sa[0] = 0;
+        return;
+    }
+    const int n0 = (n + 2) / 3, n1 = (n + 1) / 3, n2 = n / 3, n02 = n0 + n2;
+    std::vector<int> s12(n02 + 3, 0), sa12(n02 + 3, 0), s0(n0), sa0(n0);
+    const SuffixSortChunks chunks12(n02, nthreads);
+
+    // positions i mod 3 != 0, with a dummy triple at n when n mod 3 == 1
+    chunks12.run([&](const size_t c){
+        for (size_t j=chunks12.begin(c); j<chunks12.end(c); ++j){
+            s12[j] = static_cast<int>(j < static_cast<size_t>(n0) ? 3 * j + 1 : 3 * (j - n0) + 2);
+        }
+    });
+    radix_pass(s12.data(), sa12.data(), s + 2, n02, K, nthreads);
+    radix_pass(sa12.data(), s12.data(), s + 1, n02, K, nthreads);
+    radix_pass(s12.data(), sa12.data(), s, n02, K, nthreads);
+
+    // name the triples by their rank among the distinct ones: chunk counts, then a scan
+    auto new_triple = [&](const size_t k){
+        const int a = sa12[k], b = sa12[k - 1];
+        return s[a] != s[b] || s[a + 1] != s[b + 1] || s[a + 2] != s[b + 2];
+    };
+    std::vector<int> chunk_names(chunks12.nchunks);
+    chunks12.run([&](const size_t c){
+        int names = 0;
+        for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+            names += (k == 0 || new_triple(k)) ? 1 : 0;
+        }
+        chunk_names[c] = names;
+    });
+    int nnames = 0;
+    for (auto& names : chunk_names){
+        const int count = names;
+        names = nnames;
+        nnames += count;
+    }
+    chunks12.run([&](const size_t c){
+        int name = chunk_names[c];
+        for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+            name += (k == 0 || new_triple(k)) ? 1 : 0;
+            const int i = sa12[k];
+            s12[(i % 3 == 1) ? i / 3 : i / 3 + n0] = name;
+        }
+    });
+
+    if (nnames < n02){
+        dc3_suffix_sort(s12.data(), sa12.data(), n02, nnames, nthreads);
+        chunks12.run([&](const size_t c){
+            for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+                s12[sa12[k]] = static_cast<int>(k) + 1;
+            }
+        });
+    }
+    else{
+        chunks12.run([&](const size_t c){
+            for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+                sa12[s12[k] - 1] = static_cast<int>(k);
+            }
+        });
+    }
+
+    // positions i mod 3 == 0 in the order of the suffixes at i + 1, then by s[i]
+    std::vector<int> chunk_count(chunks12.nchunks);
+    chunks12.run([&](const size_t c){
+        int count = 0;
+        for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+            count += (sa12[k] < n0) ? 1 : 0;
+        }
+        chunk_count[c] = count;
+    });
+    int total = 0;
+    for (auto& count : chunk_count){
+        const int c = count;
+        count = total;
+        total += c;
+    }
+    chunks12.run([&](const size_t c){
+        int j = chunk_count[c];
+        for (size_t k=chunks12.begin(c); k<chunks12.end(c); ++k){
+            if (sa12[k] < n0){
+                s0[j++] = 3 * sa12[k];
+            }
+        }
+    });
+    radix_pass(s0.data(), sa0.data(), s, n0, K, nthreads);
+
+    // merge sa0 with sa12 without the dummy: k indexes the i mod 3 != 0 suffixes in order
+    const int offset = n0 - n1, m12 = n02 - offset;
+    auto position12 = [&](const int k){
+        const int t = sa12[k + offset];
+        return t < n0 ? 3 * t + 1 : 3 * (t - n0) + 2;
+    };
+    auto less12 = [&](const int k, const int j){
+        const int t = sa12[k + offset];
+        if (t < n0){
+            const int i = 3 * t + 1;
+            if (s[i] != s[j]) return s[i] < s[j];
+            return s12[t + n0] < s12[j / 3];
+        }
+        const int i = 3 * (t - n0) + 2;
+        if (s[i] != s[j]) return s[i] < s[j];
+        if (s[i + 1] != s[j + 1]) return s[i + 1] < s[j + 1];
+        return s12[t - n0 + 1] < s12[j / 3 + n0];
+    };
+    // number of sa0 entries among the first k merged suffixes
+    auto corank = [&](const int k){
+        int lo = std::max(0, k - m12), hi = std::min(k, n0);
+        while (lo < hi){
+            const int p = lo + (hi - lo) / 2;
+            if (less12(k - p - 1, sa0[p])){
+                hi = p;
+            }
+            else{
+                lo = p + 1;
+            }
+        }
+        return lo;
+    };
+    const SuffixSortChunks chunks(n, nthreads);
+    chunks.run([&](const size_t c){
+        const int kbegin = static_cast<int>(chunks.begin(c)), kend = static_cast<int>(chunks.end(c));
+        int p = corank(kbegin), t = kbegin - p;
+        for (int k=kbegin; k<kend; ++k){
+            if (t < m12 && (p == n0 || less12(t, sa0[p]))){
+                sa[k] = position12(t++);
+            }
+            else{
+                sa[k] = sa0[p++];
+            }
+        }
+    });
+}
+
+// suffix array of the byte text[0..n-1] by parallel DC3 on nthreads threads (0 for the
+// OpenMP default). O(n) work like divsufsort but a few times slower on one thread, so it
+// pays off with enough threads, e.g. for the long sequences whose suffix sorting dominates
+// the estimators
+inline void parallel_suffix_sort(const unsigned char* text, int* sa, const int n, const int nthreads){
+    if (n <= 0){
+        return;
+    }
+    const int nt = (nthreads > 0) ? nthreads : get_max_threads();
+    std::vector<int> s(static_cast<size_t>(n) + 3, 0);
+    const SuffixSortChunks chunks(n, nt);
+    chunks.run([&](const size_t c){
+        for (size_t i=chunks.begin(c); i<chunks.end(c); ++i){
+            s[i] = static_cast<int>(text[i]) + 1;
+        }
+    });
+    dc3_suffix_sort(s.data(), sa, n, 256, nt);
+}
+
+// threads of the parallel DC3 sorter for a text of n symbols sorted on nthreads threads
+// (0 for the OpenMP default), 0 when divsufsort is used instead: below
+// parallel_suffix_sort_min_threads, for short texts or without OpenMP
+inline int parallel_suffix_sort_threads(const int n, const int nthreads){
+#ifdef _OPENMP
+    const int nt = (nthreads > 0) ? nthreads : get_max_threads();
+    if (nt >= parallel_suffix_sort_min_threads && n >= parallel_suffix_sort_min_length){
+        return nt;
+    }
+#else
+    (void) n;
+    (void) nthreads;
+#endif
+    return 0;
+}
+
+// suffix array of text[0..n-1] into sa[0..n-1] on nthreads threads (0 for the OpenMP default):
+// parallel DC3 from parallel_suffix_sort_min_threads threads, divsufsort otherwise
+inline void suffix_sort(const unsigned char* text, int* sa, const int n, const int nthreads=1){
+    const int nt = parallel_suffix_sort_threads(n, nthreads);
+    if (nt > 0){
+        parallel_suffix_sort(text, sa, n, nt);
+        return;
+    }
+    ScopedNumThreads threads(nthreads);
+    if (divsufsort(text, sa, n) != 0){throw std::runtime_error("suffix_sort: divsufsort failed");}
+}
+
+}
+#endif // #ifndef
@@ -0,0 +1,14 @@
+from libc.stdint cimport uint8_t
+cimport cython
+cimport numpy as np
+import numpy as np
+
+cdef extern from "sweetsourcod/bit_packing.hpp" namespace "ssc":
+    size_t packed_size(size_t n, int nbits)
+    # template arguments are deduced by the C++ compiler from the sequence type
+    void pack_bits(const unsigned char* seq, size_t n, int nbits, uint8_t* out) except + nogil
+    void pack_bits(const int* seq, size_t n, int nbits, uint8_t* out) except + nogil
+    void pack_bits(const long long* seq, size_t n, int nbits, uint8_t* out) except + nogil
+    void unpack_bits(const uint8_t* packed, size_t n, int nbits, unsigned char* out) except + nogil
+    void unpack_bits(const uint8_t* packed, size_t n, int nbits, int* out) except + nogil
+    void unpack_bits(const uint8_t* packed, size_t n, int nbits, long long* out) except + nogil
@@ -0,0 +1,81 @@
+# distutils: language = c++
+cimport cython
+import numpy as np
+ctypedef long long longlong
+
+"""
+native minimal binary representation: symbols packed with nbits bits each, most significant
+bit first, as utils.get_bytes
+"""
+
+ctypedef fused symbol_t:
+    unsigned char
+    int
+    long long
+
+
+cdef _pack_bits(const symbol_t[::1] seq, int nbits):
+    cdef size_t n = seq.shape[0]
+    cdef np.ndarray[uint8_t, ndim=1] packed = np.zeros(packed_size(n, nbits), dtype='uint8')
+    if n > 0:
+        with nogil:
+            pack_bits(&seq[0], n, nbits, &packed[0])
+    return packed
+
+
+cdef _unpack_bits(const uint8_t[::1] packed, int nbits, symbol_t[::1] out):
+    cdef size_t n = out.shape[0]
+    if <size_t>packed.shape[0] < packed_size(n, nbits):
+        raise ValueError("packed buffer too short for {} symbols of {} bits".format(n, nbits))
+    if n > 0:
+        with nogil:
+            unpack_bits(&packed[0], n, nbits, &out[0])
+
+
+def _check_nbits(nbits):
+    if not 1 <= nbits <= 32:
+        raise ValueError("nbits must be in [1, 32]")
+
+
+def get_nbits(seq):
+    """number of bits of the minimal binary representation of the symbols of seq, at least 1"""
+    return max(int(np.amax(seq)).bit_length(), 1) if np.size(seq) > 0 else 1
+
+
+def pack_symbols(seq, nbits=None):
+    """
+    pack the non-negative integers of seq with nbits bits each (by default the fewest that
+    represent max(seq)), most significant bit first, returning a uint8 array of
+    ceil(len(seq) * nbits / 8) bytes. nbits in [1, 32]; 1, 2 and 4 have SIMD fast paths
+    """
+    seq = np.asarray(seq).ravel()
+    if seq.dtype == np.bool_:
+        seq = seq.view(np.uint8)
+    elif seq.size > 0 and not np.issubdtype(seq.dtype, np.integer):
+        raise ValueError("pack_symbols only accepts integer sequences, got {}".format(seq.dtype))
+    if seq.size > 0 and np.issubdtype(seq.dtype, np.signedinteger) and np.amin(seq) < 0:
+        raise ValueError("pack_symbols only accepts non-negative values")
+    if nbits is None:
+        nbits = get_nbits(seq)
+    _check_nbits(nbits)
+    if seq.dtype == np.uint8:
+        return _pack_bits[cython.uchar](seq, nbits)
+    elif seq.dtype == np.int32:
+        return _pack_bits[int](seq, nbits)
+    return _pack_bits[longlong](np.ascontiguousarray(seq, dtype='int64'), nbits)
+
+
+def unpack_symbols(packed, n, nbits, dtype='uint8'):
+    """inverse of pack_symbols: the n symbols of nbits bits in packed as an array of dtype (uint8, int32 or int64)"""
+    _check_nbits(nbits)
+    packed = np.frombuffer(packed, dtype='uint8') if isinstance(packed, bytes) else np.ascontiguousarray(packed, dtype='uint8')
+    out = np.empty(n, dtype=dtype)
+    if out.dtype == np.uint8:
+        _unpack_bits[cython.uchar](packed, nbits, out)
+    elif out.dtype == np.int32:
+        _unpack_bits[int](packed, nbits, out)
+    elif out.dtype == np.int64:
+        _unpack_bits[longlong](packed, nbits, out)
+    else:
+        raise ValueError("dtype must be uint8, int32 or int64")
+    return out
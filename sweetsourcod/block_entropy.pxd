@@ -5,4 +5,16 @@ cimport numpy as np
 import numpy as np
 
 cdef extern from "sweetsourcod/block_entropy.hpp" namespace "ssc":
-    cpdef double block_entropy_cpp(const vector[long long] sequence, size_t blocksize) except +
\ No newline at end of file
+    cpdef double block_entropy_cpp(const vector[long long] sequence, size_t blocksize) except +
+    cdef cppclass BlockEntropyTracker:
+        BlockEntropyTracker(const vector[long long] lattice, size_t blocksize) except +
+        void update(size_t i, long long x) except +
+        void apply_updates(const vector[size_t]& sites, const vector[long long]& symbols) except +
+        double entropy()
+        size_t blocksize()
+        size_t size()
+        size_t nblocks()
+        size_t nunique()
+
+cdef extern from "sweetsourcod/context_tree_weighting.hpp" namespace "ssc":
+    cpdef double ctw_code_length(const vector[long long] sequence, size_t depth) except +
\ No newline at end of file
@@ -7,3 +7,13 @@ import numpy as np
 cdef extern from "sweetsourcod/block_sorting.hpp" namespace "ssc":
     cpdef double block_sorting_estimator_uniform(const vector[long long] sequence) except +
     cdef vector[unsigned char] burrows_wheeler_transform(const vector[long long] sequence) except +
+
+    cdef double block_sorting_estimator_uniform_buffer "ssc::block_sorting_estimator_uniform"(const unsigned char* text, size_t length, int* workspace, int nthreads) except +
+    cdef int burrows_wheeler_transform_into(const unsigned char* text, size_t length, unsigned char* out, int* workspace, int nthreads) except +
+    cdef double block_sorting_estimator_adaptive(const unsigned char* text, size_t length, size_t* nsegments, int nthreads) except +
+
+cdef extern from "sweetsourcod/bwt_coder.hpp" namespace "ssc":
+    cdef enum BWTEntropyCoder "ssc::BWTEntropyCoder":
+        BWT_ARITHMETIC "ssc::BWTEntropyCoder::arithmetic"
+        BWT_HUFFMAN "ssc::BWTEntropyCoder::huffman"
+    cdef double bwt_code_length(const unsigned char* text, size_t length, size_t block_size, BWTEntropyCoder coder) except +
\ No newline at end of file
@@ -1,11 +1,82 @@
 # distutils: language = c++
 import numpy as np
 
-cpdef block_sorting(sequence, seg='uniform'):
+
+cdef as_uint8_sequence(sequence):
+    """return sequence as a contiguous uint8 array, without copying if it already is one"""
+    arr = np.asarray(sequence)
+    if arr.dtype != np.uint8:
+        if arr.size > 0 and (np.amin(arr) < 0 or np.amax(arr) > 255):
+            raise RuntimeError("sequence values must be in [0, 255]")
+        arr = arr.astype('uint8')
+    return np.ascontiguousarray(arr).ravel()
+
+
+cpdef block_sorting(sequence, seg='uniform', workspace=None, int nthreads=1):
+    """
+    seg: "uniform" cuts the BWT into sqrt(n) segments of equal length,
+         "adaptive" cuts it at the context (LCP interval) boundaries that minimise
+         the total KT code length
+    workspace: optional int32 array of size >= len(sequence) + 1, reused by the BWT
+    nthreads: threads used by the suffix sorting, 1 by default, 0 for the OpenMP default
+    """
+    cdef const unsigned char[::1] text = as_uint8_sequence(sequence)
+    cdef int[::1] work
+    cdef int* workp = NULL
+    if workspace is not None:
+        work = workspace
+        if work.shape[0] < text.shape[0] + 1:
+            raise ValueError("workspace must hold at least len(sequence) + 1 elements")
+        workp = &work[0]
     if seg == 'uniform':
-        return block_sorting_estimator_uniform(sequence)
+        return block_sorting_estimator_uniform_buffer(&text[0] if text.shape[0] > 0 else NULL, text.shape[0], workp, nthreads)
+    elif seg == 'adaptive':
+        return block_sorting_estimator_adaptive(&text[0] if text.shape[0] > 0 else NULL, text.shape[0], NULL, nthreads)
     else:
         raise NotImplementedError
 
-def bwt_sequence(sequence):
-    return np.array(burrows_wheeler_transform(sequence)).astype('uint8')
+
+def bwt_sequence(sequence, out=None, workspace=None, int nthreads=1):
+    """
+    Burrows-Wheeler transform of the reversed sequence. The input is never modified.
+    out: optional uint8 array of size len(sequence) that receives the transform
+    workspace: optional int32 array of size >= len(sequence) + 1, reused by divbwt
+    nthreads: threads used by the suffix sorting, 1 by default, 0 for the OpenMP default
+    """
+    cdef const unsigned char[::1] text = as_uint8_sequence(sequence)
+    cdef size_t length = text.shape[0]
+    if out is None:
+        out = np.empty(length, dtype='uint8')
+    cdef unsigned char[::1] bwt = out
+    cdef int[::1] work
+    cdef int* workp = NULL
+    if <size_t>bwt.shape[0] != length:
+        raise ValueError("out must have the same size as sequence")
+    if workspace is not None:
+        work = workspace
+        if <size_t>work.shape[0] < length + 1:
+            raise ValueError("workspace must hold at least len(sequence) + 1 elements")
+        workp = &work[0]
+    if length > 0:
+        burrows_wheeler_transform_into(&text[0], length, &bwt[0], workp, nthreads)
+    return out
+
+
+def bwt_compressed_size(sequence, block_size=0, coder='arithmetic'):
+    """
+    size in bits of the sequence compressed by BWT + move-to-front + zero run-length
+    + entropy coding (bzip2-like), computed natively without producing the output
+    block_size: symbols per BWT block, 0 for a single block (bzip2 -9 uses 900000)
+    coder: "arithmetic" (adaptive, ideal code length) or "huffman" (static, per block)
+    """
+    cdef const unsigned char[::1] text = as_uint8_sequence(sequence)
+    cdef BWTEntropyCoder c
+    if coder == 'arithmetic':
+        c = BWT_ARITHMETIC
+    elif coder == 'huffman':
+        c = BWT_HUFFMAN
+    else:
+        raise NotImplementedError
+    if text.shape[0] == 0:
+        return 0.
+    return bwt_code_length(&text[0], text.shape[0], block_size, c)
@@ -0,0 +1,33 @@
+from libcpp cimport bool as cbool
+from libcpp.memory cimport unique_ptr
+from libcpp.vector cimport vector
+cimport cython
+cimport numpy as np
+import numpy as np
+
+cdef extern from "sweetsourcod/compress_size.hpp" namespace "ssc":
+    cdef enum CompressAlgorithm "ssc::CompressAlgorithm":
+        COMPRESS_DEFLATE "ssc::CompressAlgorithm::deflate"
+        COMPRESS_BZIP2 "ssc::CompressAlgorithm::bzip2"
+        COMPRESS_LZMA "ssc::CompressAlgorithm::lzma"
+        COMPRESS_ZSTD "ssc::CompressAlgorithm::zstd"
+        COMPRESS_BROTLI "ssc::CompressAlgorithm::brotli"
+        COMPRESS_DEFLATE_BZIP2 "ssc::CompressAlgorithm::deflate_bzip2"
+    cdef struct IteratedCompression:
+        size_t size
+        size_t npasses
+        size_t first_size
+    cbool compress_algorithm_available(CompressAlgorithm algorithm)
+    int compress_highest_level(CompressAlgorithm algorithm)
+    IteratedCompression iterated_compressed_size(const unsigned char* data, size_t n, CompressAlgorithm algorithm, int level) except + nogil
+
+    cdef cppclass CompressionStage:
+        void update(const unsigned char* data, size_t n) except + nogil
+        size_t finish() except + nogil
+        size_t count()
+    unique_ptr[CompressionStage] make_compression_stage(CompressAlgorithm algorithm, int level, size_t buffer_size) except +
+    size_t streaming_compressed_size(const unsigned char* data, size_t n, CompressAlgorithm algorithm, int level, size_t chunk_size) except + nogil
+    # template arguments are deduced by the C++ compiler from the row type
+    void compressed_size_batch(const unsigned char* rows, size_t nrows, size_t n, const CompressAlgorithm* algorithms, const int* levels, size_t nalgorithms, cbool iterate, size_t* sizes, size_t* npasses, size_t* first_sizes, int nthreads) except + nogil
+    void compressed_size_batch(const int* rows, size_t nrows, size_t n, const CompressAlgorithm* algorithms, const int* levels, size_t nalgorithms, cbool iterate, size_t* sizes, size_t* npasses, size_t* first_sizes, int nthreads) except + nogil
+    void compressed_size_batch(const long long* rows, size_t nrows, size_t n, const CompressAlgorithm* algorithms, const int* levels, size_t nalgorithms, cbool iterate, size_t* sizes, size_t* npasses, size_t* first_sizes, int nthreads) except + nogil
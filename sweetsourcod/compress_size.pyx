@@ -0,0 +1,184 @@
+# distutils: language = c++
+cimport cython
+import numpy as np
+ctypedef long long longlong
+
+ctypedef fused row_t:
+    unsigned char
+    int
+    long long
+
+"""
+native compressed sizes: the iterated compression of zipper_compress.get_comp_size_bytes_raw
+through the C libraries of the codecs, without intermediate Python byte objects. Codecs whose
+headers were not found at build time are missing from compress_algorithms()
+"""
+
+_algorithm_names = ('deflate', 'bzip2', 'lzma', 'zstd', 'brotli', 'deflate+bzip2')
+
+
+cdef CompressAlgorithm _compress_algorithm(algorithm) except *:
+    if algorithm == 'deflate':
+        return COMPRESS_DEFLATE
+    elif algorithm == 'bzip2':
+        return COMPRESS_BZIP2
+    elif algorithm == 'lzma':
+        return COMPRESS_LZMA
+    elif algorithm == 'zstd':
+        return COMPRESS_ZSTD
+    elif algorithm == 'brotli':
+        return COMPRESS_BROTLI
+    elif algorithm == 'deflate+bzip2':
+        return COMPRESS_DEFLATE_BZIP2
+    raise NotImplementedError("unknown compression algorithm {}".format(algorithm))
+
+
+def compress_algorithms():
+    """names of the algorithms compiled into this build"""
+    return tuple(a for a in _algorithm_names if compress_algorithm_available(_compress_algorithm(a)))
+
+
+cdef int _compress_level(CompressAlgorithm a, algorithm, complevel) except *:
+    if not compress_algorithm_available(a):
+        raise NotImplementedError("{} not available in this build".format(algorithm))
+    return compress_highest_level(a) if complevel == 'HIGHEST_PROTOCOL' else complevel
+
+
+def _byte_view(data):
+    """the bytes of data (bytes or numpy array) as a contiguous uint8 array"""
+    if isinstance(data, bytes):
+        return np.frombuffer(data, dtype='uint8')
+    return np.ascontiguousarray(data).reshape(-1).view('uint8')
+
+
+def get_comp_size_bytes_native(data, complevel='HIGHEST_PROTOCOL', algorithm='deflate'):
+    """
+    compress the bytes of data (bytes or a numpy array, e.g. the minimal binary representation
+    of get_mbr_bytes), then keep compressing the output while its size decreases
+    complevel: level of the codec, "HIGHEST_PROTOCOL" for its highest level
+    algorithm: "deflate", "bzip2", "lzma", "zstd", "brotli" or "deflate+bzip2"
+    returns (size, n_passes, first_size), sizes being exact byte counts
+    """
+    cdef CompressAlgorithm a = _compress_algorithm(algorithm)
+    cdef int level = _compress_level(a, algorithm, complevel)
+    cdef const unsigned char[::1] buf = _byte_view(data)
+    cdef const unsigned char* ptr = &buf[0] if buf.shape[0] > 0 else NULL
+    cdef size_t n = buf.shape[0]
+    cdef IteratedCompression result
+    with nogil:
+        result = iterated_compressed_size(ptr, n, a, level)
+    return result.size, result.npasses, result.first_size
+
+
+cdef class CompressedSizeCounter:
+    """
+    compressed size of a stream fed chunk by chunk, measured by a counting sink: the output is
+    never materialized and memory stays bounded for inputs of any size
+        counter = CompressedSizeCounter('lzma')
+        for chunk in chunks:
+            counter.update(chunk)
+        size = counter.finish()
+    """
+    cdef unique_ptr[CompressionStage] stage
+    cdef object finished_size
+
+    def __init__(self, algorithm='deflate', complevel='HIGHEST_PROTOCOL', size_t buffer_size=65536):
+        cdef CompressAlgorithm a = _compress_algorithm(algorithm)
+        cdef int level = _compress_level(a, algorithm, complevel)
+        self.stage = make_compression_stage(a, level, buffer_size)
+        self.finished_size = None
+
+    def update(self, data):
+        """compress the bytes of data (bytes or numpy array)"""
+        if self.finished_size is not None:
+            raise RuntimeError("update after finish")
+        cdef const unsigned char[::1] buf = _byte_view(data)
+        cdef size_t n = buf.shape[0]
+        if n > 0:
+            with nogil:
+                self.stage.get().update(&buf[0], n)
+
+    def finish(self):
+        """flush the stream and return its compressed size in bytes"""
+        if self.finished_size is None:
+            with nogil:
+                self.stage.get().finish()
+            self.finished_size = self.stage.get().count()
+        return self.finished_size
+
+    @property
+    def size(self):
+        """compressed bytes emitted so far"""
+        return self.stage.get().count()
+
+
+def get_comp_size_bytes_streaming(data, complevel='HIGHEST_PROTOCOL', algorithm='deflate', size_t chunk_size=2**20):
+    """
+    single-pass compressed size of data measured without materializing the compressed output
+    data: bytes, a numpy array (e.g. a np.memmap of a large file, read chunk_size bytes at a
+    time) or an iterable of such chunks
+    """
+    cdef CompressAlgorithm a = _compress_algorithm(algorithm)
+    cdef int level = _compress_level(a, algorithm, complevel)
+    cdef const unsigned char[::1] buf
+    cdef size_t n
+    if isinstance(data, (bytes, np.ndarray)):
+        buf = _byte_view(data)
+        n = buf.shape[0]
+        if n == 0:
+            buf = np.zeros(1, dtype='uint8')
+        with nogil:
+            n = streaming_compressed_size(&buf[0], n, a, level, chunk_size)
+        return n
+    counter = CompressedSizeCounter(algorithm, complevel)
+    for chunk in data:
+        counter.update(chunk)
+    return counter.finish()
+
+
+cdef _comp_size_batch(const row_t[:, ::1] rows, vector[CompressAlgorithm] algorithms, vector[int] levels,
+                      cbool iterate, int nthreads):
+    cdef size_t nrows = rows.shape[0], n = rows.shape[1], nalgorithms = algorithms.size()
+    cdef np.ndarray[size_t, ndim=2] sizes = np.zeros((nrows, nalgorithms), dtype=np.uintp)
+    cdef np.ndarray[size_t, ndim=2] npasses = np.zeros((nrows, nalgorithms), dtype=np.uintp)
+    cdef np.ndarray[size_t, ndim=2] first_sizes = np.zeros((nrows, nalgorithms), dtype=np.uintp)
+    if nrows > 0 and nalgorithms > 0:
+        with nogil:
+            compressed_size_batch(&rows[0, 0], nrows, n, algorithms.data(), levels.data(), nalgorithms, iterate,
+                                  &sizes[0, 0], &npasses[0, 0], &first_sizes[0, 0], nthreads)
+    return sizes.astype('int64'), npasses.astype('int64'), first_sizes.astype('int64')
+
+
+def get_comp_size_bytes_batch(ensemble, algorithms=('deflate',), iterate=True, int nthreads=0):
+    """
+    compressed sizes of every row of an ensemble for several algorithms, as get_comp_size_bytes
+    (minimal binary representation, then iterated compression) but with each row packed once
+    and all (row, algorithm) jobs run on a thread pool without the GIL
+    ensemble: array of shape (ensemble, n) of non-negative ints (n > 0 and the rows of any
+              dimensionality are flattened)
+    algorithms: names (at their highest level) or (name, complevel) pairs, see compress_algorithms()
+    iterate: keep compressing while the size decreases (False for a single pass)
+    nthreads: 0 for the OpenMP default
+    returns the tables (size, n_passes, first_size), each of shape (ensemble, len(algorithms))
+    """
+    cdef vector[CompressAlgorithm] codes
+    cdef vector[int] levels
+    cdef CompressAlgorithm a
+    for entry in algorithms:
+        name, complevel = (entry, 'HIGHEST_PROTOCOL') if isinstance(entry, str) else entry
+        a = _compress_algorithm(name)
+        levels.push_back(_compress_level(a, name, complevel))
+        codes.push_back(a)
+    ensemble = np.asarray(ensemble)
+    if ensemble.ndim < 2:
+        raise ValueError("ensemble must have shape (ensemble, n)")
+    if ensemble.size > 0 and np.amin(ensemble) < 0:
+        raise ValueError("ensemble must hold non-negative ints")
+    if ensemble.dtype == np.uint8:
+        data = np.ascontiguousarray(ensemble.reshape(ensemble.shape[0], -1))
+        return _comp_size_batch[cython.uchar](data, codes, levels, iterate, nthreads)
+    elif ensemble.dtype == np.int32:
+        data = np.ascontiguousarray(ensemble.reshape(ensemble.shape[0], -1))
+        return _comp_size_batch[int](data, codes, levels, iterate, nthreads)
+    data = np.ascontiguousarray(ensemble.reshape(ensemble.shape[0], -1), dtype='int64')
+    return _comp_size_batch[longlong](data, codes, levels, iterate, nthreads)
@@ -7,4 +7,9 @@ import numpy as np
 
 cdef extern from "sweetsourcod/gosper_curve.hpp" namespace "ssc":
     cpdef long long gosper_coord2distance(const pair[double, double] pt, const int n) except +
-
+    cdef void gosper_coord2distance_batch "ssc::gosper_coord2distance"(const double* points, size_t npoints, int n, long long* distance, int nthreads) except + nogil
+    T gosper_axial2distance[T](const pair[int, int] qr, int n) except +
+    pair[int, int] gosper_distance2axial[T](T h, int n) except +
+    pair[double, double] gosper_distance2coord[T](T h, int n) except +
+    void gosper_traversal(int n, int* axial) except + nogil
+    void gosper_mask[I](int n, I* mask, size_t* boxv, int* origin) except + nogil
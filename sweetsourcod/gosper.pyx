@@ -1,5 +1,62 @@
 # distutils: language = c++
+import numpy as np
+ctypedef long long longlong
 
 cpdef get_gosper_distance(pt, n):
     return gosper_coord2distance(pt, n)
 
+
+def get_gosper_distances(points, int n, int nthreads=0):
+    """
+    distances along the level-n Gosper curve of an (M, 2) array of xy points (-1 for points
+    outside the curve), computed in parallel on nthreads threads (0 for the OpenMP default)
+    """
+    cdef np.ndarray[double, ndim=2] pts = np.ascontiguousarray(np.reshape(points, (-1, 2)), dtype='float64')
+    cdef size_t npoints = pts.shape[0]
+    cdef np.ndarray[long long, ndim=1] distance = np.empty(npoints, dtype='int64')
+    if npoints > 0:
+        with nogil:
+            gosper_coord2distance_batch(&pts[0, 0], npoints, n, &distance[0], nthreads)
+    return distance
+
+
+def get_gosper_axial_distance(qr, int n):
+    """distance along the level-n Gosper curve of the site with axial coordinates qr = (q, r), -1 if off the curve"""
+    return gosper_axial2distance[longlong](qr, n)
+
+
+def get_gosper_coord(long long h, int n):
+    """xy coordinates of the site at distance h along the level-n Gosper curve"""
+    return gosper_distance2coord[longlong](h, n)
+
+
+def get_gosper_axial(long long h, int n):
+    """axial coordinates (q, r), on the lattice of hexagons of size 7^(-n/2), of the site at distance h"""
+    return gosper_distance2axial[longlong](h, n)
+
+
+def get_gosper_traversal(int n):
+    """(7^n, 2) array of the axial coordinates (q, r) of the sites of the level-n Gosper curve in curve order"""
+    if n < 0:
+        raise ValueError("recursion level of Gosper curve should not be negative")
+    cdef np.ndarray[int, ndim=2] axial = np.empty((7 ** int(n), 2), dtype='int32')
+    with nogil:
+        gosper_traversal(n, &axial[0, 0])
+    return axial
+
+
+def get_gosper_mask(int n):
+    """
+    flat indices of the sites of the level-n Gosper curve in curve order, for a hexagonal lattice
+    stored in axial coordinates on the bounding box of the curve, as in get_hilbert_mask.
+    returns mask, lattice_boxv = [Lq, Lr] and the axial coordinates (qmin, rmin) of the box origin;
+    the site (q, r) has flat index (q - qmin) + (r - rmin) * Lq
+    """
+    if n < 0:
+        raise ValueError("recursion level of Gosper curve should not be negative")
+    cdef np.ndarray[int, ndim=1] mask = np.empty(7 ** int(n), dtype='int32')
+    cdef size_t boxv[2]
+    cdef int origin[2]
+    with nogil:
+        gosper_mask[int](n, &mask[0], boxv, origin)
+    return mask, np.array([boxv[0], boxv[1]]), (origin[0], origin[1])
@@ -0,0 +1,28 @@
+from libcpp.vector cimport vector
+from libcpp.utility cimport pair
+from libc.stdint cimport uint32_t, uint64_t
+cimport cython
+cimport numpy as np
+import numpy as np
+
+cdef extern from "sweetsourcod/hilbert_curve.hpp" namespace "ssc":
+    H hilbert_distance_from_coordinates[H](const vector[uint32_t]& coordinates, int p) except +
+    vector[uint32_t] hilbert_coordinates_from_distance[H](H h, int p, int N) except +
+    pair[uint64_t, uint64_t] hilbert_distance_from_coordinates_wide(const vector[uint32_t]& coordinates, int p) except +
+    vector[uint32_t] hilbert_coordinates_from_distance_wide(uint64_t low, uint64_t high, int p, int N) except +
+    void hilbert_mask[I](const vector[size_t]& boxv, I* mask) except + nogil
+    void pseudo_hilbert_mask[I](const vector[size_t]& boxv, I* mask) except + nogil
+
+cdef extern from "sweetsourcod/scan_curves.hpp" namespace "ssc":
+    cdef enum ScanCurve "ssc::ScanCurve":
+        SCAN_RASTER "ssc::ScanCurve::raster"
+        SCAN_HILBERT "ssc::ScanCurve::hilbert"
+        SCAN_PSEUDO_HILBERT "ssc::ScanCurve::pseudo_hilbert"
+        SCAN_MORTON "ssc::ScanCurve::morton"
+        SCAN_PEANO "ssc::ScanCurve::peano"
+        SCAN_H_CURVE "ssc::ScanCurve::h_curve"
+    void scan_mask[I](ScanCurve curve, const vector[size_t]& boxv, I* mask) except + nogil
+    # template arguments are deduced by the C++ compiler from the frame type
+    void interlaced_scan(const unsigned char* frames, size_t nframes, size_t n, const long long* mask, size_t block, unsigned char* out) except + nogil
+    void interlaced_scan(const int* frames, size_t nframes, size_t n, const long long* mask, size_t block, int* out) except + nogil
+    void interlaced_scan(const long long* frames, size_t nframes, size_t n, const long long* mask, size_t block, long long* out) except + nogil
@@ -1,9 +1,10 @@
 # distutils: language = c++
+from libc.stdint cimport uint64_t
+ctypedef long long longlong
+cimport cython
 cimport numpy as np
+from sweetsourcod.scan_mask cimport _mask_pointer
 import numpy as np
-from libc.stdlib cimport strtoul
-from libcpp.string cimport string
-from libcpp.vector cimport vector
 
 """
 on hilbert curves
@@ -60,53 +61,7 @@ from that code that appears in the paper by Skilling, ::
 .. _mapping-n-dimensional-value-to-a-point-on-hilbert-curve: http://stackoverflow.com/questions/499166/mapping-n-dimensional-value-to-a-point-on-hilbert-curve/10384110#10384110
 """
 
-cdef _binary_repr(int num, int width):
-    """Return a binary string representation of `num` zero padded to `width`
-    bits."""
-    return format(num, 'b').zfill(width).encode()
-
-cdef _hilbert_integer_to_transpose(int h, int p, int N):
-    """Store a hilbert integer (`h`) as its transpose (`x`).
-    :param h: integer distance along hilbert curve
-    :type h: ``int``
-    :param p: number of iterations in Hilbert curve
-    :type p: ``int``
-    :param N: number of dimensions
-    :type N: ``int``
-    """
-    cdef int i
-    cdef bytes h_bit_str = _binary_repr(h, p*N)
-    # x = [int(h_bit_str[i::N], 2) for i in range(N)]
-    cdef np.ndarray[int, ndim=1] x = np.empty(N, dtype='int32')
-    for i in xrange(N):
-        x[i] = int(h_bit_str[i::N], 2)
-    return x
-
-def _transpose_to_hilbert_integer(np.ndarray[int, ndim=1] x, int p, int N):
-    """Restore a hilbert integer (`h`) from its transpose (`x`).
-    :param x: the transpose of a hilbert integer (N components of length p)
-    :type x: ``list`` of ``int``
-    :param p: number of iterations in hilbert curve
-    :type p: ``int``
-    :param N: number of dimensions
-    :type N: ``int``
-    """
-    cdef int i, j, h
-    cdef string y, hstr
-    # x_bit_str = [_binary_repr(x[i], p) for i in xrange(N)]
-    # h = int(''.join([y[i] for i in xrange(p) for y in x_bit_str]), 2)
-    cdef vector[string] x_bit_str
-    for i in xrange(N):
-        x_bit_str.push_back(_binary_repr(x[i], p))
-    hstr = ''
-    for i in xrange(p):
-        for j in xrange(N):
-            y = x_bit_str[j]
-            hstr += y[i]
-    h = strtoul(hstr.c_str(), NULL, 2)
-    return h
-
-def coordinates_from_distance(int h, int p, int N):
+def coordinates_from_distance(h, int p, int N):
     """Return the coordinates for a given hilbert distance.
     :param h: integer distance along the curve
     :type h: ``int``
@@ -115,32 +70,11 @@ def coordinates_from_distance(int h, int p, int N):
     :param N: number of dimensions
     :type N: ``int``
     """
-    cdef int i, t, Q, P, Z
-    cdef np.ndarray[int, ndim=1] x = _hilbert_integer_to_transpose(h, p, N)
-    Z = 2 << (p-1)
-
-    # Gray decode by H ^ (H/2)
-    t = x[N-1] >> 1
-    for i in xrange(N-1, 0, -1):
-        x[i] ^= x[i-1]
-    x[0] ^= t
-
-    # Undo excess work
-    Q = 2
-    while Q != Z:
-        P = Q - 1
-        for i in xrange(N-1, -1, -1):
-            if x[i] & Q:
-                # invert
-                x[0] ^= P
-            else:
-                # excchange
-                t = (x[0] ^ x[i]) & P
-                x[0] ^= t
-                x[i] ^= t
-        Q <<= 1
-    # done
-    return x
+    if N * p <= 64:
+        return np.array(hilbert_coordinates_from_distance[uint64_t](h, p, N), dtype='int32')
+    h = int(h)
+    return np.array(hilbert_coordinates_from_distance_wide(h & 0xFFFFFFFFFFFFFFFF, h >> 64, p, N), dtype='int64')
+
 
 def distance_from_coordinates(xlist, int p, int N):
     """Return the hilbert distance for a given set of coordinates.
@@ -151,37 +85,13 @@ def distance_from_coordinates(xlist, int p, int N):
     :param N: number of dimensions
     :type N: ``int``
     """
-    cdef int i, M, Q, P, t, h
-    cdef np.ndarray[int, ndim=1] x = np.array(xlist, dtype='int32')
-    M = 1 << (p - 1)
-
-    # Inverse undo excess work
-    Q = M
-    while Q > 1:
-        P = Q - 1
-        for i in xrange(N):
-            if x[i] & Q:
-                x[0] ^= P
-            else:
-                t = (x[0] ^ x[i]) & P
-                x[0] ^= t
-                x[i] ^= t
-        Q >>= 1
-
-    # Gray encode
-    for i in xrange(1, N):
-        x[i] ^= x[i-1]
-    t = 0
-    Q = M
-    while Q > 1:
-        if x[N-1] & Q:
-            t ^= Q - 1
-        Q >>= 1
-    for i in xrange(N):
-        x[i] ^= t
-
-    h = _transpose_to_hilbert_integer(x, p, N)
-    return h
+    cdef vector[uint32_t] x = xlist
+    if x.size() != <size_t>N:
+        raise ValueError("len(x) must be equal to N")
+    if N * p <= 64:
+        return hilbert_distance_from_coordinates[uint64_t](x, p)
+    cdef pair[uint64_t, uint64_t] h = hilbert_distance_from_coordinates_wide(x, p)
+    return (int(h.second) << 64) | int(h.first)
 
 
 def is_power2(num):
@@ -190,72 +100,152 @@ def is_power2(num):
 
 
 def get_hilbert_scan(lattice, lattice_boxv):
-    cdef int ndim, size, distance, p, x, y, i, j
-    ndim = lattice_boxv.size
-    cdef np.ndarray[int, ndim=1] lattice_shape = np.array(lattice_boxv[::-1], dtype='int32')
-    cdef np.ndarray[int, ndim=1] scanned_lattice = np.empty(lattice.size, dtype='int32')
-    if not is_power2(np.amax(lattice_boxv)):
-        raise NotImplementedError, "Max lattice size is not a power of 2,"
-    size = np.amax(lattice_boxv)
-    p = int(np.log2(size))
-    distance = int(size ** ndim)
-    rlattice = lattice.reshape(lattice_shape)
-    j = 0
-    if ndim == 2:
-        for i in xrange(distance):
-            x, y = coordinates_from_distance(i, p, ndim)
-            if x < lattice_shape[1] and y < lattice_shape[0]:
-                scanned_lattice[j] = rlattice[y, x]
-                j += 1
-    elif ndim == 3:
-        for i in xrange(distance):
-            x, y, z = coordinates_from_distance(i, p, ndim)
-            if x < lattice_shape[2] and y < lattice_shape[1] and z < lattice_shape[0]:
-                scanned_lattice[j] = rlattice[z, y, x]
-                j += 1
-    elif ndim == 4:
-        for i in xrange(distance):
-            x1, x2, x3, x4 = coordinates_from_distance(i, p, ndim)
-            if x1 < lattice_shape[3] and x2 < lattice_shape[2] and x3 < lattice_shape[1] and x4 < lattice_shape[0]:
-                scanned_lattice[j] = rlattice[x4, x3, x2, x1]
-                j += 1
-    else:
-        raise NotImplementedError
-    return scanned_lattice
+    """return the lattice values in the order of the Hilbert mask"""
+    return np.asarray(lattice).ravel()[get_hilbert_mask(lattice_boxv)].astype('int32')
 
 
 def get_hilbert_mask(lattice_boxv):
-    cdef int ndim, size, distance, p, x, y, i, j
-    ndim = lattice_boxv.size
-    cdef np.ndarray[int, ndim=1] lattice_shape = np.array(lattice_boxv[::-1], dtype='int32')
-    cdef np.ndarray[int, ndim=1] mask = np.empty(np.prod(lattice_shape), dtype='int32')
+    """
+    flat indices of the sites of a lattice of side lengths lattice_boxv = [Lx, Ly, ...]
+    (up to 16 dimensions) in the order in which the Hilbert curve visits them. The mask is
+    int32, or int64 for lattices of 2^31 sites or more
+    """
     if not is_power2(np.amax(lattice_boxv)):
         raise NotImplementedError, "Max lattice size is not a power of 2,"
-    size = np.amax(lattice_boxv)
-    p = int(np.log2(size))
-    distance = int(size ** ndim)
-    j = 0
-    if ndim == 2:
-        for i in xrange(distance):
-            x, y = coordinates_from_distance(i, p, ndim)
-            if x < lattice_shape[1] and y < lattice_shape[0]:
-                mask[j] = x + y * lattice_boxv[0]
-                j += 1
-    elif ndim == 3:
-        lattice_boxv01 = lattice_boxv[0] * lattice_boxv[1]
-        for i in xrange(distance):
-            x, y, z = coordinates_from_distance(i, p, ndim)
-            if x < lattice_shape[2] and y < lattice_shape[1] and z < lattice_shape[0]:
-                mask[j] = x + y * lattice_boxv[0] + z * lattice_boxv01
-                j += 1
-    elif ndim == 4:
-        lattice_boxv01 = lattice_boxv[0] * lattice_boxv[1]
-        lattice_boxv012 = lattice_boxv01 * lattice_boxv[2]
-        for i in xrange(distance):
-            x1, x2, x3, x4 = coordinates_from_distance(i, p, ndim)
-            if x1 < lattice_shape[3] and x2 < lattice_shape[2] and x3 < lattice_shape[1] and x4 < lattice_shape[0]:
-                mask[j] = x1 + x2 * lattice_boxv[0] + x3 * lattice_boxv01 + x4 * lattice_boxv012
-                j += 1
-    else:
-        raise NotImplementedError
+    return get_scan_mask(lattice_boxv, 'hilbert')
+
+
+def get_pseudo_hilbert_mask(lattice_boxv):
+    """
+    flat indices of the sites of a 1, 2 or 3 dimensional lattice of arbitrary side lengths
+    lattice_boxv = [Lx, Ly, ...] in the order of a generalized Hilbert curve. Unlike
+    get_hilbert_mask no power-of-two padding is needed and the cost is O(n)
+    """
+    return get_scan_mask(lattice_boxv, 'pseudo-hilbert')
+
+
+def get_pseudo_hilbert_scan(lattice, lattice_boxv):
+    """return the lattice values in the order of the generalized Hilbert mask"""
+    return np.asarray(lattice).ravel()[get_pseudo_hilbert_mask(lattice_boxv)].astype('int32')
+
+
+scan_curves = ('raster', 'hilbert', 'pseudo-hilbert', 'morton', 'peano', 'h-curve')
+
+
+cdef ScanCurve _scan_curve(curve) except *:
+    if curve == 'raster':
+        return SCAN_RASTER
+    elif curve == 'hilbert':
+        return SCAN_HILBERT
+    elif curve == 'pseudo-hilbert':
+        return SCAN_PSEUDO_HILBERT
+    elif curve == 'morton':
+        return SCAN_MORTON
+    elif curve == 'peano':
+        return SCAN_PEANO
+    elif curve == 'h-curve':
+        return SCAN_H_CURVE
+    raise NotImplementedError("unknown scan {}".format(curve))
+
+
+def get_scan_mask(lattice_boxv, curve='hilbert'):
+    """
+    flat indices of the sites of a lattice of side lengths lattice_boxv = [Lx, Ly, ...] in the
+    order of the curve, one of
+      "raster"
+      "hilbert": Hilbert curve on the enclosing hypercube of side 2^p, up to 16 dimensions
+      "pseudo-hilbert": generalized Hilbert curve, 1 to 3 dimensions, any side lengths
+      "morton": Z-order on the enclosing hypercube of side 2^p, fastest to generate, N * p <= 64
+      "peano": Peano curve on the enclosing hypercube of side 3^p, N * p <= 40
+      "h-curve": closed H-curve on the enclosing square of side 2^p, 2 dimensions
+    The mask is int32, or int64 for lattices of 2^31 sites or more
+    """
+    cdef ScanCurve c = _scan_curve(curve)
+    cdef vector[size_t] boxv = lattice_boxv
+    cdef np.ndarray[int, ndim=1] mask
+    cdef np.ndarray[long long, ndim=1] mask64
+    n = np.prod(lattice_boxv, dtype='int64')
+    if n >= 2**31:
+        # flat indices no longer fit in int32
+        mask64 = np.empty(n, dtype='int64')
+        with nogil:
+            scan_mask[longlong](c, boxv, &mask64[0])
+        return mask64
+    mask = np.empty(n, dtype='int32')
+    if mask.size > 0:
+        with nogil:
+            scan_mask[int](c, boxv, &mask[0])
     return mask
+
+
+def get_scan(lattice, lattice_boxv, curve='hilbert'):
+    """return the lattice values in the order of the curve, see get_scan_mask"""
+    return np.asarray(lattice).ravel()[get_scan_mask(lattice_boxv, curve)].astype('int32')
+
+
+def get_morton_mask(lattice_boxv):
+    """flat indices of the sites of the lattice in Morton (Z-) order"""
+    return get_scan_mask(lattice_boxv, 'morton')
+
+
+def get_peano_mask(lattice_boxv):
+    """flat indices of the sites of the lattice in the order of the Peano curve"""
+    return get_scan_mask(lattice_boxv, 'peano')
+
+
+def get_hcurve_mask(lattice_boxv):
+    """flat indices of the sites of a 2D lattice in the order of the H-curve"""
+    return get_scan_mask(lattice_boxv, 'h-curve')
+
+
+ctypedef fused frame_t:
+    unsigned char
+    int
+    long long
+
+
+cdef _interlaced_scan(frame_t[:, ::1] frames, mask, size_t block, frame_t[::1] out):
+    cdef size_t nframes = frames.shape[0], n = frames.shape[1]
+    cdef long long[::1] m = None if mask is None else np.ascontiguousarray(mask, dtype='int64')
+    cdef const long long* mask_ptr = _mask_pointer(m, n)
+    if <size_t>out.shape[0] != nframes * n:
+        raise ValueError("out must hold nframes * frame size values")
+    if nframes > 0 and n > 0:
+        with nogil:
+            interlaced_scan(&frames[0, 0], nframes, n, mask_ptr, block, &out[0])
+
+
+def get_interlaced_scan(frames, scan='hilbert', block=1, out=None):
+    """
+    interlace the scans of the frames of a trajectory into a single sequence: blocks of block
+    consecutive scan positions are taken from every frame in turn (block=1 interlaces site by
+    site), without per-frame scanned copies
+    frames: array of shape (T, *lattice_shape)
+    scan: "raster", one of scan_curves (see get_scan_mask) or an explicit mask of flat site indices
+    block: number of consecutive scan positions taken from each frame in turn
+    out: optional contiguous 1D array of T * prod(lattice_shape) values of the dtype of frames
+    (uint8, int32 or int64) receiving the sequence
+    """
+    frames = np.asarray(frames)
+    if frames.ndim < 2:
+        raise ValueError("frames must have shape (T, *lattice_shape)")
+    if block < 1:
+        raise ValueError("block must be positive")
+    if isinstance(scan, str):
+        mask = None if scan == 'raster' else get_scan_mask(frames.shape[1:][::-1], scan)
+    else:
+        mask = scan
+    if frames.dtype not in (np.uint8, np.int32):
+        frames = frames.astype('int64')
+    data = np.ascontiguousarray(frames.reshape(frames.shape[0], -1))
+    if out is None:
+        out = np.empty(data.size, dtype=data.dtype)
+    elif out.dtype != data.dtype:
+        raise ValueError("out must have the dtype of frames")
+    if data.dtype == np.uint8:
+        _interlaced_scan[cython.uchar](data, mask, block, out)
+    elif data.dtype == np.int32:
+        _interlaced_scan[int](data, mask, block, out)
+    else:
+        _interlaced_scan[longlong](data, mask, block, out)
+    return out
@@ -15,3 +15,31 @@ cdef extern from "sweetsourcod/lempel_ziv.hpp" namespace "ssc":
     cpdef size_t cross_parsing(const vector[long long] lattice1, const vector[long long] lattice2) except +
     cpdef pair[size_t, double] cross_parsing_complexity_sumlog(const vector[long long] lattice1, const vector[long long] lattice2) except +
     cdef vector[vector[int]] get_cross_parsing_factors(const vector[long long] lattice1, const vector[long long] lattice2) except +
+
+
+    # the same functions with the number of threads of the suffix sorting
+    cdef pair[size_t, double] lempel_ziv_complexity77_sumlog_kkp_nthreads "ssc::lempel_ziv_complexity77_sumlog_kkp"(const vector[long long] lattice, int nthreads) except +
+    cdef vector[vector[int]] get_lz77_factors_nthreads "ssc::get_lz77_factors"(const vector[long long] lattice, int nthreads) except +
+    cdef pair[size_t, double] cross_parsing_complexity_sumlog_nthreads "ssc::cross_parsing_complexity_sumlog"(const vector[long long] lattice1, const vector[long long] lattice2, int nthreads) except +
+    cdef vector[vector[int]] get_cross_parsing_factors_nthreads "ssc::get_cross_parsing_factors"(const vector[long long] lattice1, const vector[long long] lattice2, int nthreads) except +
+
+    cdef enum LZ77FactorQuantity "ssc::LZ77FactorQuantity":
+        LZ77_COST "ssc::LZ77FactorQuantity::cost"
+        LZ77_LENGTH "ssc::LZ77FactorQuantity::length"
+        LZ77_INDEX "ssc::LZ77FactorQuantity::index"
+    void lz77_factor_field[I](const int* factors, size_t nfactors, const I* mask, size_t n, LZ77FactorQuantity quantity, double* field) except + nogil
+    # template arguments are deduced by the C++ compiler from the lattice type
+    void lempel_ziv_complexity77_ensemble(const unsigned char* lattices, size_t nmembers, size_t n, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+    void lempel_ziv_complexity77_ensemble(const int* lattices, size_t nmembers, size_t n, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+    void lempel_ziv_complexity77_ensemble(const long long* lattices, size_t nmembers, size_t n, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+
+    cdef cppclass LatticeSymmetry:
+        vector[int] perm
+        unsigned flips
+    vector[LatticeSymmetry] lattice_symmetries(const vector[size_t]& boxv) except +
+    void lempel_ziv_complexity77_symmetries(const unsigned char* lattice, const vector[size_t]& boxv, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+    void lempel_ziv_complexity77_symmetries(const int* lattice, const vector[size_t]& boxv, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+    void lempel_ziv_complexity77_symmetries(const long long* lattice, const vector[size_t]& boxv, const long long* mask, size_t* nfactors, double* sumlog, int nthreads) except + nogil
+    pair[size_t, double] lempel_ziv_complexity77_interlaced(const unsigned char* frames, size_t nframes, size_t n, const long long* mask, size_t block, int nthreads) except + nogil
+    pair[size_t, double] lempel_ziv_complexity77_interlaced(const int* frames, size_t nframes, size_t n, const long long* mask, size_t block, int nthreads) except + nogil
+    pair[size_t, double] lempel_ziv_complexity77_interlaced(const long long* frames, size_t nframes, size_t n, const long long* mask, size_t block, int nthreads) except + nogil
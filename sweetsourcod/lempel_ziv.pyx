@@ -1,31 +1,213 @@
 # distutils: language = c++
+cimport cython
+from sweetsourcod.scan_mask cimport _mask_pointer
+import numpy as np
+ctypedef long long longlong
 
-cpdef lempel_ziv_complexity(lattice, version='lz77'):
+ctypedef fused lattice_t:
+    unsigned char
+    int
+    long long
+
+cpdef lempel_ziv_complexity(lattice, version='lz77', int nthreads=1):
     """
     lattice: array of ints
     version: "lz76", "lz77", "lz78"
+    nthreads: threads used to build the suffix array (lz77 only), 1 by default, 0 for the OpenMP default
     """
     if version == 'lz76':
         return lempel_ziv_complexity76(lattice)
     elif version == 'lz77': #unrestricted
-        return lempel_ziv_complexity77_sumlog_kkp(lattice)
+        return lempel_ziv_complexity77_sumlog_kkp_nthreads(lattice, nthreads)
     elif version == 'lz78':
         return lempel_ziv_complexity78(lattice)
     else:
         raise NotImplementedError
 
 
-def lempel_ziv_factors(lattice, version='lz77'):
+def lempel_ziv_factors(lattice, version='lz77', int nthreads=1):
     if version == 'lz77':
-            factors = get_lz77_factors(lattice)
+            factors = get_lz77_factors_nthreads(lattice, nthreads)
     else:
         raise NotImplementedError
     return factors
     
 
-cpdef cross_parsing_complexity(lattice1, lattice2):
-    return cross_parsing_complexity_sumlog(lattice1, lattice2)
+cpdef cross_parsing_complexity(lattice1, lattice2, int nthreads=1):
+    return cross_parsing_complexity_sumlog_nthreads(lattice1, lattice2, nthreads)
+
+def cross_parsing_factors(lattice1, lattice2, int nthreads=1):
+    return get_cross_parsing_factors_nthreads(lattice1, lattice2, nthreads)
+
+
+def lempel_ziv_factor_field(factors, mask, lattice_shape=None, quantity='cost'):
+    """
+    map the LZ77 factors of a scanned lattice back onto the lattice sites
+    factors: (position, length) pairs as returned by lempel_ziv_factors
+    mask: flat indices of the lattice sites in scan order (e.g. get_hilbert_mask)
+    lattice_shape: shape of the returned field, flat if None
+    quantity: "cost" (factor code length in bits shared evenly among its sites),
+              "length" (factor length) or "index" (factor index)
+    """
+    cdef LZ77FactorQuantity q
+    if quantity == 'cost':
+        q = LZ77_COST
+    elif quantity == 'length':
+        q = LZ77_LENGTH
+    elif quantity == 'index':
+        q = LZ77_INDEX
+    else:
+        raise NotImplementedError
+    cdef np.ndarray[int, ndim=2] f = np.ascontiguousarray(np.reshape(factors, (-1, 2)), dtype='int32')
+    cdef np.ndarray[long long, ndim=1] m = np.ascontiguousarray(mask, dtype='int64')
+    cdef size_t n = m.shape[0]
+    if n > 0 and (np.amin(m) < 0 or np.amax(m) >= n):
+        raise ValueError("mask entries must be in [0, len(mask))")
+    cdef np.ndarray[double, ndim=1] field = np.zeros(n, dtype='float64')
+    cdef size_t nfactors = f.shape[0]
+    if n > 0:
+        with nogil:
+            lz77_factor_field[longlong](&f[0, 0] if nfactors > 0 else NULL, nfactors, &m[0], n, q, &field[0])
+    elif nfactors > 0:
+        raise ValueError("factors do not cover the mask")
+    if lattice_shape is not None:
+        return field.reshape(lattice_shape)
+    return field
+
+
+def _scan_order(scan, lattice_shape):
+    """mask of the scan of a lattice of the given shape, None for the raster scan"""
+    if isinstance(scan, str):
+        if scan == 'raster':
+            return None
+        if scan == 'gosper':
+            # its mask indexes the bounding box of a hexagonal patch, not a whole lattice
+            raise ValueError("the gosper scan does not fill a rectangular lattice, reorder the sites "
+                             "with sweetsourcod.gosper.get_gosper_mask and use scan='raster'")
+        from sweetsourcod.scan_cache import get_cached_mask
+        return get_cached_mask(scan, lattice_shape[::-1])
+    return scan
+
+
+cdef _complexity77_ensemble(lattice_t[:, ::1] lattices, mask, int nthreads):
+    cdef size_t nmembers = lattices.shape[0], n = lattices.shape[1]
+    cdef long long[::1] m = None if mask is None else np.ascontiguousarray(mask, dtype='int64')
+    cdef const long long* mask_ptr = _mask_pointer(m, n)
+    cdef np.ndarray[size_t, ndim=1] nfactors = np.zeros(nmembers, dtype=np.uintp)
+    cdef np.ndarray[double, ndim=1] sumlog = np.zeros(nmembers, dtype='float64')
+    if nmembers > 0 and n > 0:
+        with nogil:
+            lempel_ziv_complexity77_ensemble(&lattices[0, 0], nmembers, n, mask_ptr,
+                                             &nfactors[0], &sumlog[0], nthreads)
+    return nfactors.astype('int64'), sumlog
+
+
+def lempel_ziv_complexity_ensemble(lattices, scan='raster', int nthreads=0):
+    """
+    LZ77 complexity of every lattice of an ensemble, gathered through the scan order straight
+    into the factorizer's text buffer (no intermediate scanned or widened copies)
+    lattices: array of shape (ensemble, *lattice_shape) of ints in [0, 255]
+    scan: "raster", a curve known to sweetsourcod.scan_cache ("hilbert", "pseudo-hilbert", ...)
+          or an explicit mask of flat site indices
+    nthreads: threads across ensemble members, 0 for the OpenMP default
+    returns the arrays of the number of factors and of the sumlog code lengths
+    """
+    lattices = np.asarray(lattices)
+    if lattices.ndim < 2:
+        raise ValueError("lattices must have shape (ensemble, *lattice_shape)")
+    mask = _scan_order(scan, lattices.shape[1:])
+    if lattices.dtype == np.uint8:
+        data = np.ascontiguousarray(lattices.reshape(lattices.shape[0], -1))
+        return _complexity77_ensemble[cython.uchar](data, mask, nthreads)
+    elif lattices.dtype == np.int32:
+        data = np.ascontiguousarray(lattices.reshape(lattices.shape[0], -1))
+        return _complexity77_ensemble[int](data, mask, nthreads)
+    data = np.ascontiguousarray(lattices.reshape(lattices.shape[0], -1), dtype='int64')
+    return _complexity77_ensemble[longlong](data, mask, nthreads)
 
-def cross_parsing_factors(lattice1, lattice2):
-    return get_cross_parsing_factors(lattice1, lattice2)
 
+cdef _complexity77_interlaced(lattice_t[:, ::1] frames, mask, size_t block, int nthreads):
+    cdef size_t nframes = frames.shape[0], n = frames.shape[1]
+    cdef long long[::1] m = None if mask is None else np.ascontiguousarray(mask, dtype='int64')
+    cdef const long long* mask_ptr = _mask_pointer(m, n)
+    cdef pair[size_t, double] result = pair[size_t, double](0, 0.)
+    if nframes > 0 and n > 0:
+        with nogil:
+            result = lempel_ziv_complexity77_interlaced(&frames[0, 0], nframes, n, mask_ptr, block, nthreads)
+    return result.first, result.second
+
+
+def lempel_ziv_complexity_interlaced(frames, scan='raster', block=1, int nthreads=1):
+    """
+    LZ77 complexity of the time-interlaced scan of a trajectory (see
+    sweetsourcod.hilbert.get_interlaced_scan), written straight into the factorizer's buffer
+    frames: array of shape (T, *lattice_shape) of ints in [0, 255]
+    scan: "raster", a curve known to sweetsourcod.scan_cache or an explicit mask of flat site indices
+    block: number of consecutive scan positions taken from each frame in turn
+    nthreads: threads used to build the suffix array, 1 by default, 0 for the OpenMP default
+    returns (nfactors, sumlog)
+    """
+    frames = np.asarray(frames)
+    if frames.ndim < 2:
+        raise ValueError("frames must have shape (T, *lattice_shape)")
+    if block < 1:
+        raise ValueError("block must be positive")
+    mask = _scan_order(scan, frames.shape[1:])
+    if frames.dtype == np.uint8:
+        data = np.ascontiguousarray(frames.reshape(frames.shape[0], -1))
+        return _complexity77_interlaced[cython.uchar](data, mask, block, nthreads)
+    elif frames.dtype == np.int32:
+        data = np.ascontiguousarray(frames.reshape(frames.shape[0], -1))
+        return _complexity77_interlaced[int](data, mask, block, nthreads)
+    data = np.ascontiguousarray(frames.reshape(frames.shape[0], -1), dtype='int64')
+    return _complexity77_interlaced[longlong](data, mask, block, nthreads)
+
+
+cdef _complexity77_symmetries(lattice_t[::1] lattice, vector[size_t] boxv, mask, size_t nsymmetries, int nthreads):
+    cdef size_t n = lattice.shape[0]
+    cdef long long[::1] m = None if mask is None else np.ascontiguousarray(mask, dtype='int64')
+    cdef const long long* mask_ptr = _mask_pointer(m, n)
+    cdef np.ndarray[size_t, ndim=1] nfactors = np.zeros(nsymmetries, dtype=np.uintp)
+    cdef np.ndarray[double, ndim=1] sumlog = np.zeros(nsymmetries, dtype='float64')
+    if n > 0:
+        with nogil:
+            lempel_ziv_complexity77_symmetries(&lattice[0], boxv, mask_ptr, &nfactors[0], &sumlog[0], nthreads)
+    return nfactors.astype('int64'), sumlog
+
+
+def get_lattice_symmetries(lattice_shape):
+    """
+    symmetries of a lattice of the given shape, in the order used by
+    lempel_ziv_complexity_symmetrized: list of (perm, flips) where axis d of the transformed
+    lattice reads axis perm[d] of the original one, reversed if flips[d]. Axes are those of
+    lattice_boxv = lattice_shape[::-1]; only axes of equal length are permuted
+    """
+    cdef vector[size_t] boxv = list(lattice_shape)[::-1]
+    cdef vector[LatticeSymmetry] symmetries = lattice_symmetries(boxv)
+    return [(tuple(g.perm), tuple(bool((g.flips >> d) & 1) for d in range(boxv.size())))
+            for g in symmetries]
+
+
+def lempel_ziv_complexity_symmetrized(lattice, scan='raster', int nthreads=0):
+    """
+    LZ77 complexity of a lattice under each of its rotations and reflections (the 8 dihedral
+    transforms of a square, the 48 of a cube; see get_lattice_symmetries), factorized in
+    parallel. The scan order of every transform is derived from the base mask by index
+    arithmetic, without transposed copies of the lattice
+    lattice: array of ints in [0, 255]
+    scan: "raster", a curve known to sweetsourcod.scan_cache or an explicit mask of flat site indices
+    nthreads: threads across symmetries, 0 for the OpenMP default
+    returns (nfactors, sumlog) per symmetry and their averages (mean nfactors, mean sumlog)
+    """
+    lattice = np.asarray(lattice)
+    mask = _scan_order(scan, lattice.shape)
+    cdef vector[size_t] boxv = list(lattice.shape)[::-1]
+    cdef size_t nsymmetries = lattice_symmetries(boxv).size()
+    if lattice.dtype == np.uint8:
+        nfactors, sumlog = _complexity77_symmetries[cython.uchar](lattice.ravel(), boxv, mask, nsymmetries, nthreads)
+    elif lattice.dtype == np.int32:
+        nfactors, sumlog = _complexity77_symmetries[int](lattice.ravel(), boxv, mask, nsymmetries, nthreads)
+    else:
+        nfactors, sumlog = _complexity77_symmetries[longlong](np.ascontiguousarray(lattice.ravel(), dtype='int64'),
+                                                              boxv, mask, nsymmetries, nthreads)
+    return (nfactors, sumlog), (np.mean(nfactors), np.mean(sumlog))
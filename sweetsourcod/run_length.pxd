@@ -0,0 +1,19 @@
+from libc.stdint cimport uint8_t, uint64_t
+from libcpp.vector cimport vector
+cimport cython
+cimport numpy as np
+import numpy as np
+
+cdef extern from "sweetsourcod/run_length.hpp" namespace "ssc":
+    cdef enum RLECoding "ssc::RLECoding":
+        RLE_VARINT "ssc::RLECoding::varint"
+        RLE_ELIAS_GAMMA "ssc::RLECoding::elias_gamma"
+        RLE_ELIAS_DELTA "ssc::RLECoding::elias_delta"
+    # template arguments are deduced by the C++ compiler from the sequence type
+    vector[uint8_t] rle_encode(const unsigned char* seq, size_t n, RLECoding coding) except + nogil
+    vector[uint8_t] rle_encode(const int* seq, size_t n, RLECoding coding) except + nogil
+    vector[uint8_t] rle_encode(const long long* seq, size_t n, RLECoding coding) except + nogil
+    size_t rle_code_length(const unsigned char* seq, size_t n, RLECoding coding) except + nogil
+    size_t rle_code_length(const int* seq, size_t n, RLECoding coding) except + nogil
+    size_t rle_code_length(const long long* seq, size_t n, RLECoding coding) except + nogil
+    void rle_decode_runs(const uint8_t* data, size_t nbytes, RLECoding coding, vector[uint64_t]& symbols, vector[uint64_t]& runs) except + nogil
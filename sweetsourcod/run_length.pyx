@@ -0,0 +1,95 @@
+# distutils: language = c++
+cimport cython
+import numpy as np
+ctypedef long long longlong
+
+"""
+run-length encoding of integer sequences over an unbounded alphabet: (symbol, run) pairs
+coded with LEB128 varints ("varint", a byte stream usable as input to the compressors of
+zipper_compress and compress_size or to the LZ77 factorizer) or with Elias gamma/delta codes
+("elias-gamma", "elias-delta"), and the code length alone without writing the stream
+"""
+
+ctypedef fused symbol_t:
+    unsigned char
+    int
+    long long
+
+
+cdef RLECoding _rle_coding(coding) except *:
+    if coding == 'varint':
+        return RLE_VARINT
+    elif coding == 'elias-gamma':
+        return RLE_ELIAS_GAMMA
+    elif coding == 'elias-delta':
+        return RLE_ELIAS_DELTA
+    raise NotImplementedError("unknown run-length coding {}".format(coding))
+
+
+def _symbols(seq):
+    seq = np.asarray(seq).ravel()
+    if seq.dtype == np.uint8 or seq.dtype == np.int32:
+        return np.ascontiguousarray(seq)
+    return np.ascontiguousarray(seq, dtype='int64')
+
+
+cdef _encode(const symbol_t[::1] seq, RLECoding coding):
+    cdef size_t n = seq.shape[0]
+    cdef vector[uint8_t] stream
+    if n > 0:
+        with nogil:
+            stream = rle_encode(&seq[0], n, coding)
+    out = np.empty(stream.size(), dtype='uint8')
+    if stream.size() > 0:
+        out[:] = <uint8_t[:stream.size()]> stream.data()
+    return out
+
+
+cdef size_t _code_length(const symbol_t[::1] seq, RLECoding coding) except? 0:
+    cdef size_t n = seq.shape[0], bits = 0
+    if n > 0:
+        with nogil:
+            bits = rle_code_length(&seq[0], n, coding)
+    return bits
+
+
+def rle_encode_stream(seq, coding='varint'):
+    """run-length coded stream of the non-negative integers of seq, as a uint8 array"""
+    cdef RLECoding c = _rle_coding(coding)
+    data = _symbols(seq)
+    if data.dtype == np.uint8:
+        return _encode[cython.uchar](data, c)
+    elif data.dtype == np.int32:
+        return _encode[int](data, c)
+    return _encode[longlong](data, c)
+
+
+def rle_code_length_bits(seq, coding='varint'):
+    """length in bits of rle_encode_stream(seq, coding) (without padding), computed without writing it"""
+    cdef RLECoding c = _rle_coding(coding)
+    data = _symbols(seq)
+    if data.dtype == np.uint8:
+        return _code_length[cython.uchar](data, c)
+    elif data.dtype == np.int32:
+        return _code_length[int](data, c)
+    return _code_length[longlong](data, c)
+
+
+def rle_decode_stream(stream, coding='varint', runs_only=False, dtype='int64'):
+    """
+    decode a stream of rle_encode_stream: the sequence as an array of dtype, or its
+    (symbols, runs) arrays if runs_only
+    """
+    cdef RLECoding c = _rle_coding(coding)
+    cdef const uint8_t[::1] data = np.frombuffer(stream, dtype='uint8') if isinstance(stream, bytes) \
+        else np.ascontiguousarray(stream, dtype='uint8')
+    cdef size_t nbytes = data.shape[0]
+    cdef vector[uint64_t] symbols, runs
+    if nbytes > 0:
+        with nogil:
+            rle_decode_runs(&data[0], nbytes, c, symbols, runs)
+    symbols_array = np.asarray(symbols, dtype='uint64').astype(dtype)
+    runs_array = np.asarray(runs, dtype='int64')
+    if runs_only:
+        return symbols_array, runs_array
+    return np.repeat(symbols_array, runs_array)
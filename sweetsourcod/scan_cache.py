@@ -0,0 +1,148 @@
+from __future__ import division, absolute_import, print_function
+import os
+import tempfile
+import numpy as np
+
+"""
+persistent cache of scan masks
+
+masks are keyed by (curve, box dimensions), or (curve, level) for curves whose extent is
+fixed by their recursion level such as the Gosper curve, and stored as .npy files in a cache
+directory ($SWEETSOURCOD_CACHE, by default ~/.cache/sweetsourcod). Subsequent loads
+memory-map the file read-only, so worker processes scanning lattices of the same shape
+share a single copy of the mask through the page cache. The generator is only invoked
+on a miss and files are written atomically, so concurrent workers can share the cache.
+"""
+
+# bumped whenever a generator or the file layout changes, so stale cache files are not reused
+MASK_CACHE_VERSION = 1
+
+_scan_generators = {}
+_level_scans = set()
+_loaded_masks = {}
+
+# os.replace (atomic overwrite) is python 3 only
+_replace = getattr(os, 'replace', os.rename)
+
+
+def register_scan(curve, generator, by_level=False):
+    """
+    register generator(lattice_boxv, level) returning the mask (flat indices of the
+    lattice sites in scan order) of the curve named curve. Masks of box filling curves
+    cover the prod(lattice_boxv) sites of the box; by_level=True marks a curve whose mask
+    only depends on the level (lattice_boxv is then ignored and passed as None)
+    """
+    _scan_generators[curve] = generator
+    if by_level:
+        _level_scans.add(curve)
+    else:
+        _level_scans.discard(curve)
+
+
+def _hilbert(lattice_boxv, level):
+    from sweetsourcod.hilbert import get_hilbert_mask
+    return get_hilbert_mask(lattice_boxv)
+
+
+def _pseudo_hilbert(lattice_boxv, level):
+    from sweetsourcod.hilbert import get_pseudo_hilbert_mask
+    return get_pseudo_hilbert_mask(lattice_boxv)
+
+
+def _curve(curve):
+    def generator(lattice_boxv, level):
+        from sweetsourcod.hilbert import get_scan_mask
+        return get_scan_mask(lattice_boxv, curve)
+    return generator
+
+
+def _gosper(lattice_boxv, level):
+    # the patch, and hence its bounding box, is fixed by the level
+    from sweetsourcod.gosper import get_gosper_mask
+    return get_gosper_mask(level)[0]
+
+
+register_scan('hilbert', _hilbert)
+register_scan('pseudo-hilbert', _pseudo_hilbert)
+register_scan('gosper', _gosper, by_level=True)
+for _name in ('morton', 'peano', 'h-curve'):
+    register_scan(_name, _curve(_name))
+
+
+def get_cache_dir():
+    """directory of the mask cache, created if needed"""
+    path = os.environ.get('SWEETSOURCOD_CACHE',
+                          os.path.join(os.path.expanduser('~'), '.cache', 'sweetsourcod'))
+    if not os.path.isdir(path):
+        try:
+            os.makedirs(path)
+        except OSError:
+            if not os.path.isdir(path):
+                raise
+    return path
+
+
+def _mask_key(curve, lattice_boxv, level):
+    if curve in _level_scans:
+        return curve, None, int(level)
+    return curve, tuple(int(L) for L in lattice_boxv), 0
+
+
+def get_mask_path(curve, lattice_boxv, level=0):
+    """file holding the mask of the given curve, box dimensions (or level) and cache version"""
+    curve, boxv, level = _mask_key(curve, lattice_boxv, level)
+    if boxv is None:
+        name = 'v{}_{}_level{}.npy'.format(MASK_CACHE_VERSION, curve, level)
+    else:
+        name = 'v{}_{}_{}.npy'.format(MASK_CACHE_VERSION, curve, 'x'.join(str(L) for L in boxv))
+    return os.path.join(get_cache_dir(), name)
+
+
+def _write_mask(path, mask):
+    """atomically store mask at path, with the permissions of a file created under the umask"""
+    fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(path), suffix='.npy.tmp')
+    try:
+        with os.fdopen(fd, 'wb') as f:
+            np.save(f, mask)
+        umask = os.umask(0)
+        os.umask(umask)
+        os.chmod(tmp_path, 0o666 & ~umask)
+        _replace(tmp_path, path)
+    except BaseException:
+        if os.path.exists(tmp_path):
+            os.remove(tmp_path)
+        raise
+
+
+def get_cached_mask(curve, lattice_boxv, level=0):
+    """
+    read-only, memory-mapped mask of the curve for a lattice of side lengths
+    lattice_boxv = [Lx, Ly, ...] (or of the given level for curves registered by level),
+    generated and stored on the first request
+    """
+    if curve not in _scan_generators:
+        raise NotImplementedError("unknown scan {}".format(curve))
+    key = _mask_key(curve, lattice_boxv, level)
+    if key in _loaded_masks:
+        return _loaded_masks[key]
+    path = get_mask_path(curve, lattice_boxv, level)
+    if not os.path.exists(path):
+        boxv = None if key[1] is None else np.asarray(key[1])
+        mask = np.ascontiguousarray(_scan_generators[curve](boxv, key[2]))
+        if boxv is not None and mask.size != int(np.prod(boxv)):
+            raise ValueError("{} scan of a {} lattice has {} sites instead of {}".format(
+                curve, 'x'.join(str(L) for L in key[1]), mask.size, int(np.prod(boxv))))
+        _write_mask(path, mask)
+    mask = np.load(path, mmap_mode='r')
+    _loaded_masks[key] = mask
+    return mask
+
+
+def clear_mask_cache(remove_files=False):
+    """forget the masks loaded by this process and optionally delete the cache files"""
+    _loaded_masks.clear()
+    if remove_files:
+        path = get_cache_dir()
+        for name in os.listdir(path):
+            if name.endswith('.npy'):
+                os.remove(os.path.join(path, name))
@@ -0,0 +1,17 @@
+cdef inline const long long* _mask_pointer(long long[::1] mask, size_t n) except *:
+    """
+    pointer to the scan mask of a lattice of n sites, NULL for the raster scan (mask is None)
+    or an empty lattice. Raises ValueError unless mask holds n flat site indices in [0, n);
+    the caller keeps mask alive while the pointer is in use
+    """
+    if mask is None:
+        return NULL
+    if <size_t>mask.shape[0] != n:
+        raise ValueError("mask and lattice sizes do not match")
+    cdef size_t i
+    for i in range(n):
+        if mask[i] < 0 or <size_t>mask[i] >= n:
+            raise ValueError("mask entries must be in [0, lattice size)")
+    if n == 0:
+        return NULL
+    return &mask[0]
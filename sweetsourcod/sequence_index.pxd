@@ -0,0 +1,26 @@
+from libcpp cimport bool as cbool
+from libcpp.vector cimport vector
+from libcpp.pair cimport pair
+cimport cython
+cimport numpy as np
+import numpy as np
+
+cdef extern from "sweetsourcod/sequence_index.hpp" namespace "ssc":
+    cdef cppclass CppSequenceIndex "ssc::SequenceIndex":
+        CppSequenceIndex(const vector[long long] lattice, int nthreads) except +
+        size_t size()
+        const vector[int]& suffix_array()
+        const vector[int]& lcp_array() except +
+        const vector[unsigned char]& bwt() except +
+        vector[pair[int, int]] lz77_factors() except +
+        pair[size_t, double] lempel_ziv_complexity77() except +
+        size_t lempel_ziv_complexity76() except +
+        size_t lempel_ziv_complexity78() except +
+        double block_entropy(size_t blocksize) except +
+        double block_sorting_estimator_uniform() except +
+        double block_sorting_estimator_adaptive() except +
+        double bwt_code_length(cbool huffman) except +
+        double ctw_code_length(size_t depth) except +
+
+cdef class SequenceIndex:
+    cdef CppSequenceIndex* thisptr
@@ -0,0 +1,65 @@
+# distutils: language = c++
+import numpy as np
+
+cdef class SequenceIndex:
+    """
+    Holds one sequence and the suffix array (plus lazily the LCP array, the BWT and the
+    LZ77 factors) so that several estimators can be computed without repeating the
+    conversion and the suffix sorting. Each method returns the same value as the
+    corresponding module-level function.
+    nthreads: threads used by the suffix sorting, 1 by default, 0 for the OpenMP default
+    """
+
+    def __cinit__(self, sequence, int nthreads=1):
+        self.thisptr = new CppSequenceIndex(sequence, nthreads)
+
+    def __dealloc__(self):
+        del self.thisptr
+
+    def __len__(self):
+        return self.thisptr.size()
+
+    def suffix_array(self):
+        return np.array(self.thisptr.suffix_array(), dtype='int32')[:self.thisptr.size()]
+
+    def lcp_array(self):
+        return np.array(self.thisptr.lcp_array(), dtype='int32')
+
+    def bwt_sequence(self):
+        """Burrows-Wheeler transform of the reversed sequence, as block_sorting.bwt_sequence"""
+        return np.array(self.thisptr.bwt(), dtype='uint8')
+
+    def lempel_ziv_complexity(self, version='lz77'):
+        if version == 'lz76':
+            return self.thisptr.lempel_ziv_complexity76()
+        elif version == 'lz77':
+            return self.thisptr.lempel_ziv_complexity77()
+        elif version == 'lz78':
+            return self.thisptr.lempel_ziv_complexity78()
+        else:
+            raise NotImplementedError
+
+    def lempel_ziv_factors(self, version='lz77'):
+        if version == 'lz77':
+            return [[f.first, f.second] for f in self.thisptr.lz77_factors()]
+        else:
+            raise NotImplementedError
+
+    def block_entropy(self, blocksize=6):
+        return self.thisptr.block_entropy(blocksize + 1) - self.thisptr.block_entropy(blocksize)
+
+    def block_sorting(self, seg='uniform'):
+        if seg == 'uniform':
+            return self.thisptr.block_sorting_estimator_uniform()
+        elif seg == 'adaptive':
+            return self.thisptr.block_sorting_estimator_adaptive()
+        else:
+            raise NotImplementedError
+
+    def bwt_compressed_size(self, coder='arithmetic'):
+        if coder not in ('arithmetic', 'huffman'):
+            raise NotImplementedError
+        return self.thisptr.bwt_code_length(coder == 'huffman')
+
+    def ctw_entropy_rate(self, depth=8):
+        return self.thisptr.ctw_code_length(depth) / self.thisptr.size()
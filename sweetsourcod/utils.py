@@ -1,7 +1,6 @@
 from __future__ import division, absolute_import, print_function
 import numpy as np
 import sys
-import bitarray
 
 
 def seq_to_str(seq):
@@ -16,9 +15,16 @@ def get_bytes(seq, nbits):
     """
     get minimal binary representation (mbr) string of bytes
     https://stackoverflow.com/questions/13676183/python-choose-number-of-bits-to-represent-binary-number
+    packed natively (sweetsourcod.bit_packing) for nbits <= 32
     """
     assert nbits >= np.ceil(np.log2(np.amax(seq) + 1)), "nbits not sufficient to represent configuration"
-    fsyntax = '0{}b'.format(int(nbits))
+    # nbits = 0 (all zero sequence) formats every symbol with one bit
+    nbits = max(int(nbits), 1)
+    if nbits <= 32:
+        from sweetsourcod.bit_packing import pack_symbols
+        return pack_symbols(seq, nbits).tobytes()
+    fsyntax = '0{}b'.format(nbits)
+    import bitarray
     ba = bitarray.bitarray(''.join([format(x, fsyntax) for x in seq]))
     return ba.tobytes()
 
@@ -15,16 +15,29 @@ from itertools import groupby
 from sweetsourcod.utils import get_size_bytes, get_mbr_bytes
 
 
-def get_comp_size_bytes(seq, complevel='HIGHEST_PROTOCOL', dtype='uint8', algorithm='deflate', rle=False):
+def get_comp_size_bytes(seq, complevel='HIGHEST_PROTOCOL', dtype='uint8', algorithm='deflate', rle=False,
+                        native=False):
     assert dtype == 'uint8', 'get_comp_size_bytes requires integer sequence seq'
     assert seq.dtype == dtype
     raw_str = get_mbr_bytes(seq)
-    return get_comp_size_bytes_raw(raw_str, complevel=complevel, algorithm=algorithm, rle=rle)
+    return get_comp_size_bytes_raw(raw_str, complevel=complevel, algorithm=algorithm, rle=rle, native=native)
 
 
-def get_comp_size_bytes_raw(raw_str, complevel='HIGHEST_PROTOCOL', algorithm='deflate', rle=False):
-    if rle:
+def get_comp_size_bytes_raw(raw_str, complevel='HIGHEST_PROTOCOL', algorithm='deflate', rle=False, native=False):
+    """
+    native: run the iterated compression in sweetsourcod.compress_size (exact byte counts,
+    no intermediate Python byte objects) instead of the Python modules
+    rle: run-length encode the bytes first, True for encode_rle, or a coding of
+    sweetsourcod.run_length ("varint", "elias-gamma", "elias-delta") for its (symbol, run) stream
+    """
+    if isinstance(rle, str):
+        from sweetsourcod.run_length import rle_encode_stream
+        raw_str = rle_encode_stream(np.frombuffer(raw_str, dtype='uint8'), coding=rle).tobytes()
+    elif rle:
         raw_str = encode_rle(raw_str)
+    if native:
+        from sweetsourcod.compress_size import get_comp_size_bytes_native
+        return get_comp_size_bytes_native(raw_str, complevel=complevel, algorithm=algorithm)
     # compress once
     compr_str1 = zipper_compress(raw_str, complevel=complevel, algorithm=algorithm)
     compr_size1 = get_size_bytes(compr_str1)
@@ -157,6 +170,7 @@ def encode_rle(input_string):
     """
     run length encoding
     https://www.google.com/patents/EP0734126A1?cl=en
+    limited to 26 symbols and single digit runs, see sweetsourcod.run_length for integer sequences
     """
     s = set(input_string)
     assert len(s) <= len(string.ascii_lowercase)